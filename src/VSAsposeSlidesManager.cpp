@@ -1,8 +1,14 @@
  #include "VSAsposeSlidesManager.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
 #include <functional>
 #include <optional>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include <system/exception.h>
 #include <system/shared_ptr.h>
@@ -12,12 +18,316 @@
 #include <DOM/ISlide.h>
 #include <DOM/ISlideCollection.h>
 #include <DOM/ISlideSize.h>
+#include <Export/RenderingOptions.h>
+#include <drawing/color.h>
+#include <drawing/graphics.h>
+#include <drawing/drawing2d/interpolation_mode.h>
+#include <drawing/drawing2d/smoothing_mode.h>
+#include <drawing/imaging/pixel_format.h>
+#include <drawing/text/text_rendering_hint.h>
+#include <system/io/memory_stream.h>
 
 #include "VSUtils.h"
+#include "VSBoundedQueue.h"
+#include "VSExportPipeline.h"
+#include "VSPixelKernels.h"
+#include "VSImageEncoder.h"
 
 namespace as = Aspose::Slides;
 namespace assys = System;
 
+namespace
+{
+
+assys::SharedPtr<as::Presentation> loadPresentation(const tc::stdfs::path& file, as::LoadFormat format)
+{
+	return assys::MakeObject<as::Presentation>(
+		assys::String::FromUtf8(file.string()),
+		assys::MakeObject<as::LoadOptions>(format)
+	);
+}
+
+///@brief Renders @p slide by GetThumbnail() if @p options are default, otherwise by GDI+ graphics with quality hints
+/// of @p options over their background, which requires @p size.
+assys::SharedPtr<assys::Drawing::Bitmap> renderSlide(
+	const assys::SharedPtr<as::ISlide>& slide, const std::optional<assys::Drawing::Size>& size,
+	const tc::file_as_img::RenderOptions& options
+)
+{
+	namespace dr = assys::Drawing;
+	if(options.isDefault()) {
+		return size ? slide->GetThumbnail(*size) : slide->GetThumbnail();
+	}
+	assert(size.has_value());
+	auto bitmap = assys::MakeObject<dr::Bitmap>(size->get_Width(), size->get_Height(), dr::Imaging::PixelFormat::Format32bppArgb);
+	auto graphics = dr::Graphics::FromImage(bitmap);
+	graphics->Clear(dr::Color::FromArgb(static_cast<int>(0xFF000000u | options.background)));
+	graphics->set_SmoothingMode(
+		options.antialiasing ? dr::Drawing2D::SmoothingMode::AntiAlias : dr::Drawing2D::SmoothingMode::None
+	);
+	graphics->set_InterpolationMode(
+		options.antialiasing ? dr::Drawing2D::InterpolationMode::HighQualityBicubic : dr::Drawing2D::InterpolationMode::NearestNeighbor
+	);
+	if(options.antialiasing) {
+		graphics->set_TextRenderingHint(
+			options.textHinting ? dr::Text::TextRenderingHint::AntiAliasGridFit : dr::Text::TextRenderingHint::AntiAlias
+		);
+	}
+	else {
+		graphics->set_TextRenderingHint(
+			options.textHinting ? dr::Text::TextRenderingHint::SingleBitPerPixelGridFit : dr::Text::TextRenderingHint::SingleBitPerPixel
+		);
+	}
+	slide->RenderToGraphics(assys::MakeObject<as::Export::RenderingOptions>(), graphics, *size);
+	return bitmap;
+}
+
+///@brief Slide passed between stages of export pipeline.
+struct RenderedSlide
+{
+	assys::SharedPtr<assys::Drawing::Bitmap> bitmap;
+	int slide;
+};
+
+struct EncodedSlide
+{
+	std::vector<std::uint8_t> bytes;
+	int slide;
+};
+
+///@brief Slide of @p size filled with background colour, which is exported in place of slide exceeding its budget.
+assys::SharedPtr<assys::Drawing::Bitmap> placeholderOf(assys::Drawing::Size size, const tc::file_as_img::RenderOptions& options)
+{
+	namespace dr = assys::Drawing;
+	auto bitmap = assys::MakeObject<dr::Bitmap>(size.get_Width(), size.get_Height(), dr::Imaging::PixelFormat::Format32bppArgb);
+	dr::Graphics::FromImage(bitmap)->Clear(dr::Color::FromArgb(static_cast<int>(0xFF000000u | options.background)));
+	return bitmap;
+}
+
+///@brief Renders slides in threads, every thread owns its own Presentation as Aspose objects are not thread safe.
+/// Thread i renders slides[i], slides[i + N], slides[i + 2N], ... to its queue, so slides are received in order
+/// by popping queues round-robin. Threads touch shared state only, never the manager.
+/// Abandonable threads still running when they are stopped are detached rather than joined, so slide which never
+/// finishes rendering does not block its caller. At most maxAbandonedThreads of them may run in the process, as they
+/// keep Aspose objects alive, starting abandonable threads beyond that fails.
+class SlideWorkerThreads
+{
+public:
+	using Bitmap = assys::SharedPtr<assys::Drawing::Bitmap>;
+
+	static constexpr std::size_t maxAbandonedThreads = 16;
+
+	SlideWorkerThreads() = default;
+	SlideWorkerThreads(const SlideWorkerThreads&) = delete;
+	SlideWorkerThreads& operator=(const SlideWorkerThreads&) = delete;
+
+	~SlideWorkerThreads()
+	{
+		if(m_shared)
+		{
+			m_shared->stopped = true;
+			for(auto& queue : m_queues) {
+				queue->close();
+			}
+		}
+		for(std::size_t i = 0; i < m_workers.size(); ++i) {
+			stop(i);
+		}
+	}
+
+	///@param pres is used by the first thread, others load their own presentation of @p file.
+	///@param onPresentationAbandoned is called if the first thread is abandoned with @p pres, which must not be
+	/// used by anyone else then.
+	///@throw std::runtime_error if threads are abandonable and maxAbandonedThreads are running.
+	void start(
+		assys::SharedPtr<as::Presentation> pres, const tc::stdfs::path& file, as::LoadFormat format,
+		const std::vector<int>& slides, std::optional<assys::Drawing::Size> size,
+		const tc::file_as_img::RenderOptions& renderOptions, std::shared_ptr<tc::file_as_img::IExportObserver> observer,
+		std::size_t workerCount, bool abandonable, std::function<void()> onPresentationAbandoned = {}
+	)
+	{
+		assert(!m_shared);
+		assert(workerCount > 0);
+		if(abandonable && abandonedThreads >= maxAbandonedThreads) {
+			throw std::runtime_error("Too many slides exceeding their budgets are still rendered");
+		}
+		m_shared = std::make_shared<Shared>();
+		m_shared->file = file;
+		m_shared->format = format;
+		m_shared->slideIndices = slides;
+		m_shared->workerCount = workerCount;
+		m_shared->size = size;
+		m_shared->renderOptions = renderOptions;
+		m_shared->observer = std::move(observer);
+		m_abandonable = abandonable;
+		m_onPresentationAbandoned = std::move(onPresentationAbandoned);
+		for(std::size_t i = 0; i < workerCount; ++i) {
+			m_queues.push_back(std::make_shared<tc::BoundedQueue<Result>>(1));
+		}
+		m_presentationShared = true;
+		for(std::size_t i = 0; i < workerCount; ++i) {
+			m_workers.push_back(startWorker(m_queues[i], i == 0 ? pres : nullptr, i));
+		}
+	}
+
+	Bitmap receive(std::size_t slideIndex, const std::function<void()>& checkInterrupt)
+	{
+		assert(m_shared);
+		auto& queue = *m_queues[slideIndex % m_queues.size()];
+		Result result;
+		for(;;)
+		{
+			auto status = queue.popFor(result, std::chrono::milliseconds(100));
+			checkInterrupt();
+			if(status == tc::BoundedQueue<Result>::Status::Ok) {
+				break;
+			}
+			if(status == tc::BoundedQueue<Result>::Status::Closed) {
+				throw std::runtime_error("Slide worker thread has terminated unexpectedly");
+			}
+		}
+		if(result.error) {
+			std::rethrow_exception(result.error);
+		}
+		assert(result.bitmap);
+		return result.bitmap;
+	}
+
+	///@brief Abandons thread rendering slide at @p slideIndex, which is not received, and starts new thread
+	/// rendering the rest of its slides, so receiving continues with slide at @p slideIndex + 1.
+	///@pre threads are abandonable.
+	void skip(std::size_t slideIndex)
+	{
+		assert(m_abandonable);
+		std::size_t worker = slideIndex % m_queues.size();
+		m_queues[worker]->close();
+		stop(worker);
+		m_queues[worker] = std::make_shared<tc::BoundedQueue<Result>>(1);
+		m_workers[worker] = startWorker(m_queues[worker], nullptr, slideIndex + m_queues.size());
+	}
+
+private:
+	struct Result
+	{
+		Bitmap bitmap;
+		std::exception_ptr error;
+	};
+
+	struct Shared
+	{
+		std::atomic_bool stopped = false;
+		tc::stdfs::path file;
+		as::LoadFormat format;
+		std::vector<int> slideIndices;
+		std::size_t workerCount = 0;
+		std::optional<assys::Drawing::Size> size;
+		tc::file_as_img::RenderOptions renderOptions;
+		std::shared_ptr<tc::file_as_img::IExportObserver> observer;
+	};
+
+	enum class State
+	{
+		Running,
+		Finished,
+		Abandoned
+	};
+
+	struct Worker
+	{
+		std::thread thread;
+		std::shared_ptr<std::atomic<State>> state;
+	};
+
+	//Abandoned threads which have not finished yet, in all instances.
+	static inline std::atomic<std::size_t> abandonedThreads = 0;
+
+	Worker startWorker(
+		std::shared_ptr<tc::BoundedQueue<Result>> queue, assys::SharedPtr<as::Presentation> pres, std::size_t first
+	)
+	{
+		auto state = std::make_shared<std::atomic<State>>(State::Running);
+		std::thread thread([shared = m_shared, queue = std::move(queue), pres = std::move(pres), first, state]() mutable {
+			run(std::move(shared), std::move(queue), std::move(pres), first);
+			if(state->exchange(State::Finished) == State::Abandoned) {
+				--abandonedThreads;
+			}
+		});
+		return {std::move(thread), std::move(state)};
+	}
+
+	///@brief Joins thread of @p worker if it is not abandonable or has finished, detaches it otherwise.
+	void stop(std::size_t worker)
+	{
+		Worker& stopped = m_workers[worker];
+		bool abandoned = false;
+		if(m_abandonable)
+		{
+			//Counted before the thread may see itself abandoned and uncount itself.
+			++abandonedThreads;
+			State running = State::Running;
+			abandoned = stopped.state->compare_exchange_strong(running, State::Abandoned);
+			if(!abandoned) {
+				--abandonedThreads;
+			}
+		}
+		if(abandoned)
+		{
+			stopped.thread.detach();
+			if(worker == 0 && m_presentationShared && m_onPresentationAbandoned) {
+				m_onPresentationAbandoned();
+			}
+		}
+		else {
+			stopped.thread.join();
+		}
+		if(worker == 0) {
+			m_presentationShared = false;
+		}
+	}
+
+	///@brief Renders slides at indices @p first, @p first + N, ... where N is number of workers.
+	static void run(
+		std::shared_ptr<const Shared> shared, std::shared_ptr<tc::BoundedQueue<Result>> queue,
+		assys::SharedPtr<as::Presentation> pres, std::size_t first
+	)
+	{
+		try
+		{
+			if(first >= shared->slideIndices.size()) {
+				return;
+			}
+			if(!pres) {
+				pres = loadPresentation(shared->file, shared->format);
+			}
+			auto slides = pres->get_Slides();
+			for(std::size_t i = first; i < shared->slideIndices.size() && !shared->stopped; i += shared->workerCount)
+			{
+				int slide = shared->slideIndices[i];
+				tc::file_as_img::StageTimer timer(shared->observer.get(), tc::file_as_img::Stage::Render, shared->file, slide);
+				Bitmap bitmap = renderSlide(slides->idx_get(slide), shared->size, shared->renderOptions);
+				timer.finish(std::uint64_t(bitmap->get_Width()) * bitmap->get_Height());
+				if(!queue->push({bitmap, nullptr})) {
+					return;
+				}
+			}
+		}
+		catch(...)
+		{
+			queue->push({nullptr, std::current_exception()});
+		}
+	}
+
+	bool m_abandonable = false;
+	//Whether the running thread of worker 0 is the first one, which renders presentation of caller.
+	bool m_presentationShared = false;
+	std::function<void()> m_onPresentationAbandoned;
+	std::shared_ptr<Shared> m_shared;
+	std::vector<std::shared_ptr<tc::BoundedQueue<Result>>> m_queues;
+	std::vector<Worker> m_workers;
+};
+
+}
+
 VSAsposeSlidesManager::VSAsposeSlidesManager() :
 	tc::file_as_img::AbstractInterruptible<tc::file_as_img::fs::IExporter>(
 		std::make_unique<VSStdAtomicBoolInterruptor>()
@@ -30,7 +340,8 @@ VSAsposeSlidesManager::VSAsposeSlidesManager() :
 	),
 	tc::file_as_img::AbstractInterruptible<tc::file_as_img::mem::IThumbnailGenerator>(
 		std::make_unique<VSStdAtomicBoolInterruptor>()
-	)
+	),
+	m_bufferPool(std::make_shared<tc::file_as_img::mem::BufferPool>(tc::file_as_img::mem::BufferPool::defaultMaxIdleBytes))
 {}
 
 void VSAsposeSlidesManager::exportAsImages(
@@ -42,8 +353,8 @@ void VSAsposeSlidesManager::exportAsImages(
 	using Interface = tc::file_as_img::IInterruptible<tc::file_as_img::mem::IExporter>;
 	validateArgumentsMem<Interface>(fileFormat, pixelFormat, options);
 	transformAsposeError([&]{
-		exportAsBitmaps<Interface>(file, fileFormat, options, [&](auto bitmap) {
-			forEachImage(makeImageFromBitmap<Interface>(bitmap, pixelFormat, options));
+		exportAsBitmaps<Interface>(file, fileFormat, options, [&](auto bitmap, int slide) {
+			forEachImage(makeImageFromBitmap<Interface>(bitmap, pixelFormat, options, file, slide));
 		});
 	});
 }
@@ -58,10 +369,43 @@ void VSAsposeSlidesManager::exportAsImages(
 {
 	using Interface = tc::file_as_img::IInterruptible<tc::file_as_img::fs::IExporter>;
 	validateArgumentsFS<Interface>(fileFormat, imageFormat, options);
+	std::size_t pipelineDepth = tc::file_as_img::exportOptionsFrom(options).pipelineDepth;
 	transformAsposeError([&]{
-		exportAsBitmaps<Interface>(file, fileFormat, options, [&](auto bitmap) {
-			forEachImageName(saveBitmap<Interface>(bitmap, outputDir, imageFormat, imageNameGenerator, options));
+		if(pipelineDepth == 0)
+		{
+			exportAsBitmaps<Interface>(file, fileFormat, options, [&](auto bitmap, int slide) {
+				forEachImageName(
+					saveBitmap<Interface>(bitmap, outputDir, imageFormat, imageNameGenerator, options, file, slide)
+				);
+			});
+			return;
+		}
+		using tc::file_as_img::Stage;
+		ExportOptions exportOptions = tc::file_as_img::exportOptionsFrom(options);
+		tc::file_as_img::IExportObserver* observer = exportOptions.observer.get();
+		tc::file_as_img::fs::ExportPipeline<RenderedSlide, EncodedSlide> pipeline(
+			pipelineDepth,
+			[&imageFormat, &exportOptions, &file, observer](RenderedSlide& rendered) {
+				tc::file_as_img::StageTimer timer(observer, Stage::Encode, file, rendered.slide);
+				EncodedSlide encoded{encodeBitmap(rendered.bitmap, imageFormat, exportOptions), rendered.slide};
+				timer.finish(0, encoded.bytes.size());
+				return encoded;
+			},
+			[&outputDir, &file, observer](const EncodedSlide& encoded, const String& imageName) {
+				tc::file_as_img::StageTimer timer(observer, Stage::Write, file, encoded.slide);
+				tc::file_as_img::fs::writeImageFile(
+					outputDir / imageName, reinterpret_cast<const char*>(encoded.bytes.data()), encoded.bytes.size()
+				);
+				timer.finish(0, encoded.bytes.size());
+			},
+			forEachImageName
+		);
+		exportAsBitmaps<Interface>(file, fileFormat, options, [&](auto bitmap, int slide) {
+			String imageName = imageNameGenerator();
+			Interface::checkInterrupt();
+			pipeline.push({bitmap, slide}, std::move(imageName));
 		});
+		pipeline.finish();
 	});
 }
 
@@ -71,10 +415,14 @@ auto VSAsposeSlidesManager::generateThumbnail(
 {
 	using Interface = tc::file_as_img::IInterruptible<tc::file_as_img::mem::IThumbnailGenerator>;
 	validateArgumentsMem<Interface>(fileFormat, pixelFormat, options);
+	Interface::checkInterrupt();
+	if(auto thumbnail = embeddedThumbnailOf(file, fileFormat, options, pixelFormat)) {
+		return std::move(thumbnail->image);
+	}
 	std::unique_ptr<IImage> img;
 	transformAsposeError([&] {
-		exportAsBitmaps<Interface>(file, fileFormat, options, [&](auto bitmap) {
-			img = makeImageFromBitmap<Interface>(bitmap, pixelFormat, options);
+		exportAsBitmaps<Interface>(file, fileFormat, options, [&](auto bitmap, int slide) {
+			img = makeImageFromBitmap<Interface>(bitmap, pixelFormat, options, file, slide);
 		});
 	});
 	return img;
@@ -90,15 +438,65 @@ auto VSAsposeSlidesManager::generateThumbnail(
 
 	using Interface = tc::file_as_img::IInterruptible<tc::file_as_img::fs::IThumbnailGenerator>;
 	validateArgumentsFS<Interface>(fileFormat, imageFormat, options);
+	Interface::checkInterrupt();
+	if(tc::file_as_img::enc::isEncoded(imageFormat))
+	{
+		if(auto thumbnail = embeddedThumbnailOf(file, fileFormat, options, "argb32"))
+		{
+			//Preview already in requested format is written as is, otherwise it is encoded from decoded pixels.
+			std::vector<std::uint8_t> bytes;
+			if(imageFormat == thumbnail->imageFormat || (imageFormat == "jpg" && thumbnail->imageFormat == "jpeg")) {
+				bytes = std::move(thumbnail->bytes);
+			}
+			else
+			{
+				const auto& image = *thumbnail->image;
+				tc::file_as_img::enc::encode(
+					reinterpret_cast<const std::uint8_t*>(image.data()), image.width(), image.height(),
+					static_cast<std::ptrdiff_t>(image.stride()), true, imageFormat,
+					tc::file_as_img::exportOptionsFrom(options),
+					[&bytes](const std::uint8_t* data, std::size_t size) {
+						bytes.insert(bytes.end(), data, data + size);
+					}
+				);
+			}
+			String imageName = imageNameGenerator();
+			Interface::checkInterrupt();
+			tc::file_as_img::fs::writeImageFile(
+				outputDir / imageName, reinterpret_cast<const char*>(bytes.data()), bytes.size()
+			);
+			return imageName;
+		}
+	}
 	String imageName;
 	transformAsposeError([&] {
-		exportAsBitmaps<Interface>(file, fileFormat, options, [&](auto bitmap) {
-			imageName = saveBitmap<Interface>(bitmap, outputDir, imageFormat, imageNameGenerator, options);
+		exportAsBitmaps<Interface>(file, fileFormat, options, [&](auto bitmap, int slide) {
+			imageName = saveBitmap<Interface>(bitmap, outputDir, imageFormat, imageNameGenerator, options, file, slide);
 		});
 	});
 	return imageName;
 }
 
+void VSAsposeSlidesManager::setDocumentCache(std::shared_ptr<tc::file_as_img::DocumentCache> cache)
+{
+	m_documentCache = std::move(cache);
+}
+
+void VSAsposeSlidesManager::setBufferPool(std::shared_ptr<tc::file_as_img::mem::BufferPool> pool)
+{
+	m_bufferPool = std::move(pool);
+}
+
+std::string VSAsposeSlidesManager::backendVersion()
+{
+	//Revision is incremented on changes of rendering which affect produced pixels.
+#ifdef VS_ASPOSE_SLIDES_VERSION
+	return std::string("aspose-slides-") + VS_ASPOSE_SLIDES_VERSION + "-r1";
+#else
+	return "aspose-slides-r1";
+#endif
+}
+
 void VSAsposeSlidesManager::validateFileFormat(const FileFormat& fileFormat)
 {
 	if(!supportedFileFormats.count(fileFormat)) {
@@ -110,12 +508,7 @@ template<typename Interface>
 bool VSAsposeSlidesManager::areOptionsValid(const Any& options)
 {
 	static_assert(tc::file_as_img::isThumbnailGenerator<Interface> || tc::file_as_img::isExporter<Interface>);
-	if constexpr (tc::file_as_img::isThumbnailGenerator<Interface>) {
-		return !options.has_value() || static_cast<bool>(std::any_cast<DPI>(&options));
-	}
-	else {
-		return !options.has_value();
-	}
+	return tc::file_as_img::holdsExportOptions(options);
 }
 
 template<typename Interface>
@@ -143,7 +536,7 @@ void VSAsposeSlidesManager::validateArgumentsMem(
 )
 {
 	validateFileFormat(fileFormat);
-	if(!supportedPixelFormats.left.count(pixelFormat)) {
+	if(!supportedPixelFormats.count(pixelFormat)) {
 		throw tc::err::exc::InvalidArgument("Invalid pixel format");
 	}
 	validateOptions<Interface>(options);
@@ -160,6 +553,20 @@ void VSAsposeSlidesManager::transformAsposeError(F f)
 	}
 }
 
+auto VSAsposeSlidesManager::embeddedThumbnailOf(
+	const Path& file, const FileFormat& fileFormat, const Any& options, const PixelFormat& pixelFormat
+) -> std::optional<tc::file_as_img::EmbeddedThumbnail>
+{
+	ExportOptions exportOptions = tc::file_as_img::exportOptionsFrom(options);
+	//Preview shows the first slide, so it can not stand for thumbnail of another one.
+	if(!exportOptions.embeddedThumbnail.enabled || !packageFileFormats.count(fileFormat) ||
+		exportOptions.pages.nth(0) != 0)
+	{
+		return std::nullopt;
+	}
+	return tc::file_as_img::readEmbeddedThumbnail(file, exportOptions, pixelFormat);
+}
+
 template<typename Interface, typename F>
 void VSAsposeSlidesManager::exportAsBitmaps(
 	const Path& file, const FileFormat& fileFormat, const Any& options, F forEachBitmap
@@ -169,42 +576,102 @@ void VSAsposeSlidesManager::exportAsBitmaps(
 	assert(areOptionsValid<Interface>(options));
 
 	constexpr bool thumbnail = tc::file_as_img::isThumbnailGenerator<Interface>;
-	auto checkInterrupt = [this] {
-		return Interface::checkInterrupt();
+	using tc::file_as_img::Stage;
+	using tc::file_as_img::CancellationToken;
+	ExportOptions exportOptions = tc::file_as_img::exportOptionsFrom(options);
+	CancellationToken documentToken = exportOptions.cancellation.withTimeout(exportOptions.timeouts.document);
+	auto checkInterrupt = [this, &documentToken] {
+		Interface::checkInterrupt();
+		documentToken.check();
 	};
+	//Slide exceeding its budget is replaced by placeholder if options allow it, exceeded budget of document fails export.
+	auto isPlaceholderAllowed = [&exportOptions, &documentToken] {
+		return exportOptions.timeouts.placeholder && !documentToken.isExpired();
+	};
+	bool pageBudget = exportOptions.timeouts.page.count() > 0;
 
 	checkInterrupt();
-	auto pres = assys::MakeObject<as::Presentation>(
-		assys::String::FromUtf8(file.string()),
-		assys::MakeObject<as::LoadOptions>(supportedFileFormats.at(fileFormat))
+	tc::file_as_img::StageTimer loadTimer(exportOptions.observer.get(), Stage::Load, file);
+	tc::file_as_img::CachedDocument<assys::SharedPtr<as::Presentation>> pres(
+		m_documentCache, file, "aspose:" + fileFormat, [&] {
+			return loadPresentation(file, supportedFileFormats.at(fileFormat));
+		}
 	);
+	loadTimer.finish();
 	checkInterrupt();
-	auto slides = pres->get_Slides();
+	auto slides = pres.get()->get_Slides();
 	checkInterrupt();
 	auto slideCount = slides->get_Count();
 	checkInterrupt();
-	if(thumbnail && slideCount < 1) {
+	std::vector<int> slideIndices = exportOptions.pages.resolve(slideCount);
+	if(thumbnail && slideIndices.empty()) {
 		throw tc::file_as_img::NoDataAvailableForThumbnail();
 	}
+	if(thumbnail) {
+		slideIndices.resize(1);
+	}
+	//Thumbnails are rendered at fixed scale of GetThumbnail() unless they are fitted in box, rendered with
+	//non default quality settings or have budget, which needs size of placeholder.
 	std::optional<System::Drawing::Size> imgPixelSize;
-	if constexpr (!thumbnail)
+	if(!thumbnail || !exportOptions.fitWithin.empty() || !exportOptions.render.isDefault() || pageBudget)
 	{
-		auto slidePointSize = pres->get_SlideSize()->get_Size();
-		DPI dpi = options.has_value() ? std::any_cast<DPI>(options) : 96.0;
-		imgPixelSize = System::Drawing::Size(
-			tc::pointsToPixels(slidePointSize.get_Width(), dpi),
-			tc::pointsToPixels(slidePointSize.get_Height(), dpi)
+		auto slidePointSize = pres.get()->get_SlideSize()->get_Size();
+		auto [width, height] = tc::file_as_img::pixelSizeOf(
+			exportOptions, slidePointSize.get_Width(), slidePointSize.get_Height()
 		);
+		imgPixelSize = System::Drawing::Size(width, height);
 	}
 	checkInterrupt();
-	for(decltype(slideCount) i = 0; i < (thumbnail ? 1 : slideCount); ++i)
+	//Slides with budget are rendered by abandonable threads even if one worker is requested,
+	//so slide exceeding budget is left to its thread rather than awaited. The first thread renders presentation
+	//of caller, which is not returned to document cache if that thread is abandoned.
+	if(!slideIndices.empty() && (pageBudget || (!thumbnail && exportOptions.workers > 1 && slideIndices.size() > 1)))
+	{
+		assert(imgPixelSize.has_value());
+		slides = nullptr;
+		SlideWorkerThreads workers;
+		workers.start(
+			pres.get(), file, supportedFileFormats.at(fileFormat), slideIndices, imgPixelSize, exportOptions.render,
+			exportOptions.observer, std::clamp<std::size_t>(exportOptions.workers, 1, slideIndices.size()), pageBudget,
+			[&pres] {
+				pres.forget();
+			}
+		);
+		for(std::size_t i = 0; i < slideIndices.size(); ++i)
+		{
+			//Budget of slide is counted from the moment it is awaited, its thread may have started it earlier.
+			CancellationToken pageToken = documentToken.withTimeout(exportOptions.timeouts.page);
+			assys::SharedPtr<assys::Drawing::Bitmap> slideBitmap;
+			try
+			{
+				slideBitmap = workers.receive(i, [this, &pageToken] {
+					Interface::checkInterrupt();
+					pageToken.check();
+				});
+			}
+			catch(const tc::err::exc::Timeout&)
+			{
+				if(!isPlaceholderAllowed()) {
+					throw;
+				}
+				workers.skip(i);
+				slideBitmap = placeholderOf(*imgPixelSize, exportOptions.render);
+			}
+			checkInterrupt();
+			std::invoke(forEachBitmap, slideBitmap, slideIndices[i]);
+			checkInterrupt();
+		}
+		return;
+	}
+	for(int i : slideIndices)
 	{
 		auto slide = slides->idx_get(i);
 		checkInterrupt();
-		assert(!thumbnail == imgPixelSize.has_value());
-		auto slideBitmap = thumbnail ? slide->GetThumbnail() : slide->GetThumbnail(*imgPixelSize);
+		tc::file_as_img::StageTimer renderTimer(exportOptions.observer.get(), Stage::Render, file, i);
+		auto slideBitmap = renderSlide(slide, imgPixelSize, exportOptions.render);
+		renderTimer.finish(std::uint64_t(slideBitmap->get_Width()) * slideBitmap->get_Height());
 		checkInterrupt();
-		std::invoke(forEachBitmap, slideBitmap);
+		std::invoke(forEachBitmap, slideBitmap, i);
 		checkInterrupt();
 	}
 }
@@ -213,33 +680,148 @@ template<typename Interface>
 auto VSAsposeSlidesManager::saveBitmap(
 	System::SharedPtr<System::Drawing::Bitmap> bitmap,
 	const Path& outputDir, const ImageFormat& imageFormat,
-	const AnyImageNameGenerator& imageNameGenerator, const Any& options
+	const AnyImageNameGenerator& imageNameGenerator, const Any& options, const Path& file, int slide
 ) -> String
 {
 	assert(supportedImageFormats.count(imageFormat));
 	assert(areOptionsValid<Interface>(options));
 
+	using tc::file_as_img::Stage;
+	ExportOptions exportOptions = tc::file_as_img::exportOptionsFrom(options);
 	String imageName = imageNameGenerator();
 	Interface::checkInterrupt();
+	if(tc::file_as_img::enc::isEncoded(imageFormat))
+	{
+		tc::file_as_img::StageTimer encodeTimer(exportOptions.observer.get(), Stage::Encode, file, slide);
+		std::vector<std::uint8_t> bytes = encodeBitmap(bitmap, imageFormat, exportOptions);
+		encodeTimer.finish(0, bytes.size());
+		Interface::checkInterrupt();
+		tc::file_as_img::StageTimer writeTimer(exportOptions.observer.get(), Stage::Write, file, slide);
+		tc::file_as_img::fs::writeImageFile(
+			outputDir / imageName, reinterpret_cast<const char*>(bytes.data()), bytes.size()
+		);
+		writeTimer.finish(0, bytes.size());
+		return imageName;
+	}
+	//Bitmap::Save encodes and writes at once, so it is reported as encode stage.
+	tc::file_as_img::StageTimer encodeTimer(exportOptions.observer.get(), Stage::Encode, file, slide);
+	std::error_code err;
+	tc::stdfs::remove(outputDir / imageName, err);
 	bitmap->Save(
 		assys::String::FromUtf8((outputDir / imageName).string()),
 		std::invoke(supportedImageFormats.at(imageFormat))
 	);
+	std::uintmax_t bytes = tc::stdfs::file_size(outputDir / imageName, err);
+	encodeTimer.finish(0, err ? 0 : bytes);
 	return imageName;
 }
 
+auto VSAsposeSlidesManager::encodeBitmap(
+	System::SharedPtr<System::Drawing::Bitmap> bitmap, const ImageFormat& imageFormat, const ExportOptions& options
+) -> std::vector<std::uint8_t>
+{
+	assert(supportedImageFormats.count(imageFormat));
+
+	std::vector<std::uint8_t> bytes;
+	if(tc::file_as_img::enc::isEncoded(imageFormat))
+	{
+		auto bitmapData = bitmap->LockBits(
+			assys::Drawing::Rectangle({0, 0}, bitmap->get_Size()),
+			assys::Drawing::Imaging::ImageLockMode::ReadOnly,
+			ASPixelFormat::Format32bppArgb
+		);
+		const auto* pixels = reinterpret_cast<const std::uint8_t*>(bitmapData->get_Scan0());
+		std::size_t width = bitmapData->get_Width();
+		std::size_t height = bitmapData->get_Height();
+		std::ptrdiff_t stride = bitmapData->get_Stride();
+		auto append = [&bytes](const std::uint8_t* data, std::size_t size) {
+			bytes.insert(bytes.end(), data, data + size);
+		};
+		try {
+			tc::file_as_img::enc::encode(pixels, width, height, stride, true, imageFormat, options, append);
+		}
+		catch(...)
+		{
+			bitmap->UnlockBits(bitmapData);
+			throw;
+		}
+		bitmap->UnlockBits(bitmapData);
+		return bytes;
+	}
+	auto stream = assys::MakeObject<assys::IO::MemoryStream>();
+	bitmap->Save(stream, std::invoke(supportedImageFormats.at(imageFormat)));
+	auto array = stream->ToArray();
+	bytes.assign(array->data().begin(), array->data().end());
+	return bytes;
+}
+
 template<typename Interface>
 auto VSAsposeSlidesManager::makeImageFromBitmap(
-	System::SharedPtr<System::Drawing::Bitmap> bitmap, const PixelFormat& pixelFormat, const Any& options
+	System::SharedPtr<System::Drawing::Bitmap> bitmap, const PixelFormat& pixelFormat, const Any& options,
+	const Path& file, int slide
 ) -> std::unique_ptr<IImage>
 {
-	assert(supportedPixelFormats.left.count(pixelFormat));
+	assert(supportedPixelFormats.count(pixelFormat));
 	assert(areOptionsValid<Interface>(options));
 
 	auto checkInterrupt = [this] {
 		Interface::checkInterrupt();
 	};
-	return std::make_unique<Image>(bitmap, supportedPixelFormats.left.at(pixelFormat));
+	using Image = tc::file_as_img::mem::Image;
+	using Size = IImage::Size;
+	assert(bitmap->get_Width() > 0);
+	assert(bitmap->get_Height() > 0);
+
+	checkInterrupt();
+	tc::file_as_img::StageTimer timer(
+		tc::file_as_img::exportOptionsFrom(options).observer.get(), tc::file_as_img::Stage::Convert, file, slide
+	);
+	auto bitmapData = bitmap->LockBits(
+		assys::Drawing::Rectangle({0, 0}, bitmap->get_Size()),
+		assys::Drawing::Imaging::ImageLockMode::ReadOnly,
+		ASPixelFormat::Format32bppArgb
+	);
+	Size width = bitmapData->get_Width();
+	Size height = bitmapData->get_Height();
+	const auto* scan0 = reinterpret_cast<const IImage::Byte*>(bitmapData->get_Scan0());
+	if(pixelFormat == "argb32")
+	{
+		timer.finish(std::uint64_t(width) * height);
+		//Locked pixels are handed out without copying and unlocked with the image.
+		return std::make_unique<Image>(
+			scan0,
+			[bitmap, bitmapData](const IImage::Byte*) {
+				bitmap->UnlockBits(bitmapData);
+			},
+			width, height, static_cast<Size>(bitmapData->get_Stride()), pixelFormat
+		);
+	}
+
+	const tc::pixel::Kernels& kernels = tc::pixel::kernels();
+	auto convertRow = pixelFormat == "rgba8888" ? kernels.argb32ToRgba8888 : kernels.argb32ToRgb888;
+	Size stride = width * tc::file_as_img::mem::bytesPerPixelOf(pixelFormat);
+	tc::file_as_img::mem::BufferPool::Buffer buffer = m_bufferPool
+		? m_bufferPool->acquire(stride * height)
+		: tc::file_as_img::mem::BufferPool::Buffer(new IImage::Byte[stride * height]);
+	for(Size y = 0; y < height; ++y)
+	{
+		convertRow(
+			reinterpret_cast<const std::uint32_t*>(scan0 + static_cast<std::ptrdiff_t>(y) * bitmapData->get_Stride()),
+			reinterpret_cast<std::uint8_t*>(buffer.get() + y * stride),
+			width
+		);
+	}
+	bitmap->UnlockBits(bitmapData);
+	auto image = std::make_unique<Image>(
+		buffer.get(),
+		[releaser = buffer.get_deleter()](const IImage::Byte* data) {
+			releaser(const_cast<IImage::Byte*>(data));
+		},
+		width, height, stride, pixelFormat
+	);
+	buffer.release();
+	timer.finish(std::uint64_t(width) * height);
+	return image;
 //	auto bitmapSize = bitmap->get_Size();
 //	checkInterrupt();
 //	auto fmt = assys::Drawing::Imaging::PixelFormat::Format32bppArgb;
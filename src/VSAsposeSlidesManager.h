@@ -1,8 +1,16 @@
 #pragma once
 
 #include "VSExportFileAsImages.h"
+#include "VSExportOptions.h"
+#include "VSDocumentCache.h"
+#include "VSBufferPool.h"
+#include "VSEmbeddedThumbnail.h"
 
+#include <cstdint>
+#include <optional>
 #include <type_traits>
+#include <unordered_set>
+#include <vector>
 
 #include <boost/assign.hpp>
 
@@ -10,6 +18,7 @@
 #include <drawing/imaging/image_format.h>
 #include <drawing/imaging/pixel_format.h>
 #include <drawing/bitmap.h>
+#include <system/array.h>
 
 #include "VSUtils.h"
 
@@ -40,6 +49,7 @@ public:
 		{"fodp", ASFileFormat::Fodp}
 	};
 
+	///@brief Formats without Aspose image format are encoded only by encoders of this library.
 	inline static const std::unordered_map<ImageFormat, ASImageFormat> supportedImageFormats = {
 		{"bmp", System::Drawing::Imaging::ImageFormat::get_Bmp},
 		{"emf", System::Drawing::Imaging::ImageFormat::get_Emf},
@@ -49,62 +59,25 @@ public:
 		{"jpg", System::Drawing::Imaging::ImageFormat::get_Jpeg},
 		{"png", System::Drawing::Imaging::ImageFormat::get_Png},
 		{"tiff", System::Drawing::Imaging::ImageFormat::get_Tiff},
-		{"exif", System::Drawing::Imaging::ImageFormat::get_Exif}
+		{"exif", System::Drawing::Imaging::ImageFormat::get_Exif},
+		{"webp", nullptr}
 	};
 
-	inline static const tc::UnorderedBimap<PixelFormat, ASPixelFormat> supportedPixelFormats =
-		boost::assign::list_of<tc::UnorderedBimap<PixelFormat, ASPixelFormat>::relation>
-		("argb32", ASPixelFormat::Format32bppArgb);
-
-	using DPI = double;
-
-	class Image : public IImage
-	{
-	public:
-		Image(
-			System::SharedPtr<System::Drawing::Bitmap> bitmap,
-			ASPixelFormat format
-		) : bitmap(bitmap)
-		{
-			assert(this->bitmap != nullptr);
-			assert(supportedPixelFormats.right.count(format));
-			assert(this->bitmap->get_Width() > 0);
-			assert(this->bitmap->get_Height() > 0);
-
-			this->bitmapData = this->bitmap->LockBits(
-				System::Drawing::Rectangle({0, 0}, this->bitmap->get_Size()),
-				System::Drawing::Imaging::ImageLockMode::ReadOnly,
-				format
-			);
-			assert(this->bitmapData);
-		}
-
-		Size width() const override {
-			assert(bitmapData->get_Width() > 0);
-			return bitmapData->get_Width();
-		}
-		Size height() const override {
-			assert(bitmapData->get_Height() > 0);
-			return bitmapData->get_Height();
-		}
-		PixelFormat format() const override {
-			assert(supportedPixelFormats.right.count(bitmapData->get_PixelFormat()));
-			return supportedPixelFormats.right.at(bitmapData->get_PixelFormat());
-		}
-		const Byte* data() const override {
-			assert(reinterpret_cast<const Byte*>(bitmapData->get_Scan0()));
-			return reinterpret_cast<const Byte*>(bitmapData->get_Scan0());
-		}
-
-		~Image() {
-			bitmap->UnlockBits(bitmapData);
-		}
-
-	private:
-		System::SharedPtr<System::Drawing::Bitmap> bitmap;
-		System::Drawing::Imaging::BitmapDataPtr bitmapData;
+	///@brief Zip packages, which may carry preview image used as thumbnail if ExportOptions::embeddedThumbnail enables it.
+	inline static const std::unordered_set<FileFormat> packageFileFormats = {
+		"pptx", "ppsx", "potx", "pptm", "ppsm", "potm", "odp", "otp"
 	};
 
+	///@brief Bitmaps are locked as Format32bppArgb, other pixel formats are converted by pixel kernels.
+	inline static const std::unordered_set<PixelFormat> supportedPixelFormats = {
+		"argb32",
+		"rgba8888",
+		"rgb888"
+	};
+
+	using ExportOptions = tc::file_as_img::ExportOptions;
+	using DPI = ExportOptions::DPI;
+
 	VSAsposeSlidesManager();
 
 	void exportAsImages(
@@ -132,6 +105,19 @@ public:
 		const Any& options
 	) override;
 
+	///@brief Enables reuse of loaded presentations across calls by @p cache, which may be shared with other backends,
+	/// nullptr disables it. Not thread safe relative to exports.
+	void setDocumentCache(std::shared_ptr<tc::file_as_img::DocumentCache> cache);
+	///@brief Draws pixel buffers of in-memory images from @p pool, which may be shared with other backends,
+	/// nullptr disables pooling. Every instance starts with its own pool. Not thread safe relative to exports.
+	void setBufferPool(std::shared_ptr<tc::file_as_img::mem::BufferPool> pool);
+	const std::shared_ptr<tc::file_as_img::mem::BufferPool>& bufferPool() const {
+		return m_bufferPool;
+	}
+
+	///@brief Identifies rendering code and library version, images rendered by different versions may differ.
+	static std::string backendVersion();
+
 private:
 	static void validateFileFormat(const FileFormat& fileFormat);
 	template<typename Interface>
@@ -150,19 +136,35 @@ private:
 	template<typename F>
 	static void transformAsposeError(F f);
 
+	///@return embedded preview of @p file decoded to @p pixelFormat if @p options enable it for thumbnail of first page.
+	static std::optional<tc::file_as_img::EmbeddedThumbnail> embeddedThumbnailOf(
+		const Path& file, const FileFormat& fileFormat, const Any& options, const PixelFormat& pixelFormat
+	);
+
+	///@brief Invokes @p forEachBitmap with every rendered slide and its index.
 	template<typename Interface, typename F>
 	void exportAsBitmaps(const Path& file, const FileFormat& fileFormat, const Any& options, F forEachBitmap);
 
+	///@brief Formats of tc::file_as_img::enc::isEncoded() are encoded from locked bitmap bits, others by Bitmap::Save.
+	static std::vector<std::uint8_t> encodeBitmap(
+		System::SharedPtr<System::Drawing::Bitmap> bitmap, const ImageFormat& imageFormat, const ExportOptions& options
+	);
+
+	///@param file and @p slide are reported to observer of @p options.
 	template<typename Interface>
 	String saveBitmap(
 		System::SharedPtr<System::Drawing::Bitmap> bitmap,
 		const Path& outputDir, const ImageFormat& imageFormat,
-		const AnyImageNameGenerator& imageNameGenerator, const Any& options
+		const AnyImageNameGenerator& imageNameGenerator, const Any& options, const Path& file, int slide
 	);
 
+	///@param file and @p slide are reported to observer of @p options.
 	template<typename Interface>
 	std::unique_ptr<IImage> makeImageFromBitmap(
 		System::SharedPtr<System::Drawing::Bitmap> bitmap,
-		const PixelFormat& pixelFormat, const Any& options
+		const PixelFormat& pixelFormat, const Any& options, const Path& file, int slide
 	);
+
+	std::shared_ptr<tc::file_as_img::DocumentCache> m_documentCache;
+	std::shared_ptr<tc::file_as_img::mem::BufferPool> m_bufferPool;
 };
\ No newline at end of file
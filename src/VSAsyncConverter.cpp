@@ -0,0 +1,68 @@
+#include "VSAsyncConverter.h"
+
+#include <cassert>
+#include <exception>
+#include <memory>
+
+VSAsyncConverter::VSAsyncConverter(VSConverter& converter, std::size_t threadCount) :
+	m_converter(converter), m_pool(threadCount)
+{}
+
+VSAsyncConverter::~VSAsyncConverter()
+{
+	cancelAll();
+}
+
+auto VSAsyncConverter::submit(Job job, Priority priority, ProgressCallback onImage) -> Handle
+{
+	return post(std::move(job), priority, [this, onImage = std::move(onImage)](const Job& job) {
+		Images images;
+		m_converter.convert(job, [&images, &onImage](const String& imageName) {
+			images.push_back(imageName);
+			if(onImage) {
+				onImage(imageName, images.size());
+			}
+		});
+		return images;
+	});
+}
+
+auto VSAsyncConverter::submitThumbnail(Job job, Priority priority) -> Handle
+{
+	return post(std::move(job), priority, [this](const Job& job) {
+		return Images{m_converter.thumbnail(job)};
+	});
+}
+
+auto VSAsyncConverter::post(Job job, Priority priority, Run run) -> Handle
+{
+	{
+		std::lock_guard lock(m_mutex);
+		job.options.cancellation = m_cancellation.child();
+	}
+	//Task of pool must be copyable, so promise is shared with it.
+	auto promise = std::make_shared<std::promise<Images>>();
+	Handle handle(promise->get_future(), job.options.cancellation);
+	m_pool.post(
+		[job = std::move(job), run = std::move(run), promise] {
+			try
+			{
+				//Job cancelled while it has been queued is not started.
+				job.options.cancellation.check();
+				promise->set_value(run(job));
+			}
+			catch(...) {
+				promise->set_exception(std::current_exception());
+			}
+		},
+		static_cast<int>(priority)
+	);
+	return handle;
+}
+
+void VSAsyncConverter::cancelAll()
+{
+	std::lock_guard lock(m_mutex);
+	m_cancellation.cancel();
+	m_cancellation = tc::file_as_img::CancellationToken();
+}
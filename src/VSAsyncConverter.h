@@ -0,0 +1,86 @@
+#pragma once
+
+#include <functional>
+#include <future>
+#include <mutex>
+#include <vector>
+
+#include "VSCancellationToken.h"
+#include "VSConverter.h"
+#include "VSThreadPool.h"
+
+///@brief Runs conversions of VSConverter on its own threads and returns handles of submitted jobs right away.
+///
+/// Queued jobs of higher priority are started first, so interactive requests like thumbnails (the first page fitted
+/// in small box) are not queued behind bulk exports, running jobs are not preempted though. Every job is cancelled
+/// by its own handle through cancellation token of its options, independently of other jobs on the same backends.
+/// Jobs either convert all selected pages or generate thumbnail of the first one.
+class VSAsyncConverter
+{
+public:
+	using Job = VSConverter::Job;
+	using String = VSConverter::String;
+	using Images = std::vector<String>;
+	///@brief Called on converting thread for every produced image with its name and number of images produced so far.
+	using ProgressCallback = std::function<void(const String& imageName, std::size_t imageCount)>;
+
+	enum class Priority
+	{
+		Bulk,
+		Normal,
+		Interactive
+	};
+
+	class Handle
+	{
+	public:
+		///@return names of images produced by job, or exception of its conversion once it is finished,
+		/// tc::err::exc::Interrupted if it has been cancelled. Future is valid until it is taken by get().
+		std::future<Images>& future() {
+			return m_future;
+		}
+
+		///@brief Cancels job whether it is queued or running, thread safe.
+		void cancel() {
+			m_cancellation.cancel();
+		}
+
+	private:
+		friend class VSAsyncConverter;
+
+		Handle(std::future<Images> future, tc::file_as_img::CancellationToken cancellation) :
+			m_future(std::move(future)), m_cancellation(std::move(cancellation))
+		{}
+
+		std::future<Images> m_future;
+		tc::file_as_img::CancellationToken m_cancellation;
+	};
+
+	///@param converter must outlive this instance.
+	VSAsyncConverter(VSConverter& converter, std::size_t threadCount);
+	VSAsyncConverter(const VSAsyncConverter&) = delete;
+	VSAsyncConverter& operator=(const VSAsyncConverter&) = delete;
+	///@brief Cancels all jobs and waits for them, their futures receive tc::err::exc::Interrupted.
+	~VSAsyncConverter();
+
+	///@brief Queues conversion of @p job, its cancellation token is replaced by child of token of this instance,
+	/// thread safe.
+	Handle submit(Job job, Priority priority = Priority::Normal, ProgressCallback onImage = {});
+	///@brief Queues generation of thumbnail of @p job as submit() does, future receives single image name.
+	Handle submitThumbnail(Job job, Priority priority = Priority::Interactive);
+
+	///@brief Cancels all queued and running jobs, jobs submitted later are not affected, thread safe.
+	void cancelAll();
+
+private:
+	using Run = std::function<Images(const Job& job)>;
+
+	Handle post(Job job, Priority priority, Run run);
+
+	VSConverter& m_converter;
+	std::mutex m_mutex;
+	///@brief Parent of tokens of jobs submitted since the last cancelAll().
+	tc::file_as_img::CancellationToken m_cancellation;
+	//Destroyed first, so remaining jobs are finished while the rest of instance exists.
+	tc::ThreadPool m_pool;
+};
@@ -0,0 +1,105 @@
+#include <atomic>
+#include <exception>
+#include <future>
+#include <iostream>
+#include <string>
+
+#include "VSAsyncConverter.h"
+
+//Checks that VSAsyncConverter cancels running conversion and queued thumbnail without starting it, and still runs
+//jobs submitted later. Documents are taken from test corpus, exit status is number of failed checks.
+
+namespace
+{
+
+int failures = 0;
+
+void expect(bool condition, const std::string& what)
+{
+	if(!condition)
+	{
+		++failures;
+		std::cerr << "FAILED " << what << std::endl;
+	}
+}
+
+///@return true if @p future receives tc::err::exc::Interrupted, which is not tc::err::exc::Timeout.
+bool isCancelled(std::future<VSAsyncConverter::Images>& future)
+{
+	try {
+		future.get();
+	}
+	catch(const tc::err::exc::Timeout&) {
+		return false;
+	}
+	catch(const tc::err::exc::Interrupted&) {
+		return true;
+	}
+	catch(const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+	}
+	return false;
+}
+
+VSAsyncConverter::Job jobOf(const std::string& file, const VSConverter::Path& outputDir, const std::string& imagePrefix)
+{
+	VSAsyncConverter::Job job;
+	job.file = VSConverter::Path(VS_TEST_CORPUS) / file;
+	job.fileFormat = job.file.extension().string().substr(1);
+	job.outputDir = outputDir;
+	job.imagePrefix = imagePrefix;
+	return job;
+}
+
+}
+
+int main()
+{
+	VSConverter::Path outputDir = tc::stdfs::temp_directory_path() / "fileAsImg_async_converter_test";
+	tc::stdfs::remove_all(outputDir);
+	tc::stdfs::create_directories(outputDir);
+
+	VSConverter converter;
+	//Single thread, so the second job is queued until the first one is finished.
+	VSAsyncConverter asyncConverter(converter, 1);
+
+	std::promise<void> started;
+	std::promise<void> cancelled;
+	std::shared_future<void> cancelledFuture = cancelled.get_future().share();
+	//t.pdf has 31 pages, so conversion is still running when it is cancelled after the first page.
+	auto running = asyncConverter.submit(
+		jobOf("t.pdf", outputDir, "running-"), VSAsyncConverter::Priority::Bulk,
+		[&started, cancelledFuture](const VSConverter::String&, std::size_t imageCount) {
+			if(imageCount == 1)
+			{
+				started.set_value();
+				cancelledFuture.wait();
+			}
+		}
+	);
+	started.get_future().wait();
+
+	auto queued = asyncConverter.submitThumbnail(jobOf("t.pptx", outputDir, "queued-"));
+	queued.cancel();
+	running.cancel();
+	cancelled.set_value();
+
+	expect(isCancelled(running.future()), "running conversion is cancelled");
+	expect(isCancelled(queued.future()), "queued thumbnail is cancelled");
+	expect(!tc::stdfs::exists(outputDir / "queued-0.png"), "queued thumbnail is not started");
+
+	auto thumbnail = asyncConverter.submitThumbnail(jobOf("t.pdf", outputDir, "thumbnail-"));
+	try
+	{
+		VSAsyncConverter::Images images = thumbnail.future().get();
+		expect(images.size() == 1 && images.front() == "thumbnail-0.png", "thumbnail is named by prefix");
+		expect(tc::stdfs::exists(outputDir / "thumbnail-0.png"), "thumbnail is written");
+	}
+	catch(const std::exception& e)
+	{
+		expect(false, std::string("thumbnail after cancellations: ") + e.what());
+	}
+
+	tc::stdfs::remove_all(outputDir);
+	return failures;
+}
@@ -0,0 +1,113 @@
+#include "VSBatch.h"
+
+#include <atomic>
+#include <cassert>
+#include <mutex>
+#include <vector>
+
+#include <boost/algorithm/string/split.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "VSJson.h"
+#include "VSThreadPool.h"
+
+VSBatch::VSBatch(VSConverter& converter, std::size_t jobs, VSConverter::ExportOptions defaultOptions) :
+	m_converter(converter), m_jobs(jobs), m_defaultOptions(std::move(defaultOptions)),
+	m_cancellation(m_defaultOptions.cancellation.child())
+{
+	assert(m_jobs > 0);
+}
+
+bool VSBatch::run(std::istream& manifest, std::ostream& report)
+{
+	std::mutex reportMutex;
+	std::atomic_bool succeeded = true;
+	auto reportLine = [&](const std::string& line) {
+		std::lock_guard lock(reportMutex);
+		report << line << std::endl;
+	};
+
+	tc::ThreadPool pool(m_jobs);
+	std::string line;
+	for(std::size_t lineNumber = 1; std::getline(manifest, line); ++lineNumber)
+	{
+		if(!line.empty() && line.back() == '\r') {
+			line.pop_back();
+		}
+		if(line.empty() || line.front() == '#') {
+			continue;
+		}
+		pool.post([this, line, lineNumber, &succeeded, &reportLine] {
+			std::string result = "{\"line\":" + std::to_string(lineNumber);
+			auto fail = [&](const char* status, const std::exception& e) {
+				succeeded = false;
+				result += ",\"status\":\"" + std::string(status) + "\",\"error\":" + tc::json::quoted(e.what()) + "}";
+			};
+			try
+			{
+				Job job = parseEntry(line, m_defaultOptions);
+				job.options.cancellation = m_cancellation.child();
+				job.imagePrefix = job.file.stem().string() + "-" + std::to_string(lineNumber) + "-";
+				result += ",\"input\":" + tc::json::quoted(job.file.string());
+				std::vector<std::string> imageNames;
+				m_converter.convert(job, [&](const std::string& imageName) {
+					imageNames.push_back(imageName);
+				});
+				result += ",\"status\":\"ok\",\"images\":[";
+				for(std::size_t i = 0; i < imageNames.size(); ++i) {
+					result += (i ? "," : "") + tc::json::quoted(imageNames[i]);
+				}
+				result += "]}";
+			}
+			catch(const tc::err::exc::Timeout& e) {
+				fail("timeout", e);
+			}
+			catch(const tc::err::exc::Interrupted& e) {
+				fail("cancelled", e);
+			}
+			catch(const std::exception& e) {
+				fail("error", e);
+			}
+			reportLine(result);
+		});
+	}
+	pool.wait();
+	return succeeded;
+}
+
+void VSBatch::cancel()
+{
+	m_cancellation.cancel();
+}
+
+auto VSBatch::parseEntry(const std::string& line, const VSConverter::ExportOptions& defaultOptions) -> Job
+{
+	std::vector<std::string> fields;
+	boost::algorithm::split(fields, line, [](char c) { return c == '\t'; });
+	if(fields.size() < 2 || fields.size() > 6 || fields[0].empty() || fields[1].empty()) {
+		throw tc::err::exc::InvalidArgument("Invalid manifest entry");
+	}
+	Job job;
+	job.file = fields[0];
+	job.fileFormat = fields[1];
+	job.options = defaultOptions;
+	if(fields.size() > 2 && !fields[2].empty()) {
+		job.outputDir = fields[2];
+	}
+	if(fields.size() > 3 && !fields[3].empty()) {
+		job.imageFormat = fields[3];
+	}
+	if(fields.size() > 4 && !fields[4].empty())
+	{
+		try {
+			job.options.dpi = boost::lexical_cast<VSConverter::ExportOptions::DPI>(fields[4]);
+		}
+		catch(const boost::bad_lexical_cast&) {
+			throw tc::err::exc::InvalidArgument("Invalid dpi in manifest entry");
+		}
+	}
+	if(fields.size() > 5 && !fields[5].empty()) {
+		job.options.pages = tc::file_as_img::PageSet::parse(fields[5]);
+	}
+	return job;
+}
\ No newline at end of file
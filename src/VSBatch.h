@@ -0,0 +1,42 @@
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "VSConverter.h"
+
+///@brief Converts documents listed in manifest by shared backends on pool of threads.
+///
+/// Manifest holds one entry per line, fields are separated by tabs:
+/// input-file, input-format[, output-dir[, output-format[, dpi[, pages]]]], pages are given as for PageSet::parse.
+/// Empty lines and lines starting with '#' are skipped.
+/// Entries run concurrently and may share output directory, so names of their images are prefixed by stem
+/// of input file and line number of entry, <stem>-<line>-<image index>.<output-format>.
+/// For every entry one JSON line is reported as soon as the entry is finished:
+/// {"line":3,"input":"a.pdf","status":"ok","images":["a-3-0.png","a-3-1.png"]} or
+/// {"line":4,"input":"b.ppt","status":"error","error":"..."}.
+/// Status is "timeout" instead of "error" if entry has exceeded its budget and "cancelled" if batch has been cancelled.
+class VSBatch
+{
+public:
+	using Job = VSConverter::Job;
+
+	VSBatch(VSConverter& converter, std::size_t jobs, VSConverter::ExportOptions defaultOptions);
+
+	///@return true if all entries have been converted successfully.
+	bool run(std::istream& manifest, std::ostream& report);
+
+	///@brief Cancels conversions of all entries of running and later runs, thread safe.
+	void cancel();
+
+	///@throw tc::err::exc::InvalidArgument if @p line is not valid manifest entry.
+	static Job parseEntry(const std::string& line, const VSConverter::ExportOptions& defaultOptions);
+
+private:
+	VSConverter& m_converter;
+	std::size_t m_jobs;
+	VSConverter::ExportOptions m_defaultOptions;
+	///@brief Parent of cancellation tokens of entries.
+	tc::file_as_img::CancellationToken m_cancellation;
+};
\ No newline at end of file
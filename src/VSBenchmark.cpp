@@ -0,0 +1,383 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <QtPdf/QPdfDocument>
+#include <QImage>
+#include <QPainter>
+
+#include <system/shared_ptr.h>
+#include <DOM/Presentation.h>
+#include <DOM/LoadOptions.h>
+#include <DOM/ISlide.h>
+#include <DOM/ISlideCollection.h>
+#include <DOM/ISlideSize.h>
+#include <drawing/bitmap.h>
+#include <drawing/imaging/bitmap_data.h>
+#include <drawing/imaging/image_lock_mode.h>
+#include <drawing/imaging/pixel_format.h>
+#include <drawing/rectangle.h>
+
+#include "VSAsposeSlidesManager.h"
+#include "VSExportOptions.h"
+#include "VSImageEncoder.h"
+#include "VSPixelKernels.h"
+#include "VSQtPdfManager.h"
+
+//Measures stages of conversion of the first page of every document of corpus directory, test/input by default:
+//Load/<file> - document loading by QPdfDocument::load or Presentation construction;
+//Render/<file>/<dpi> - rendering of page by the library at several dpi;
+//Flatten/<file>/<qpainter|inplace> - compositing of rendered pdf page over white by QPainter into second image,
+//as it was done before, or in place by VSQtPdfManager::flattenOver;
+//Convert/<file>/<pixel format> - conversion of rendered page to pixel format as by makeImage, with LockBits for slides;
+//Encode/<file>/<image format> - encoding of argb32 page by encoders of this library.
+//Results are reported as JSON unless --benchmark_format is given, so they can be diffed between builds.
+
+namespace
+{
+
+namespace as = Aspose::Slides;
+namespace assys = System;
+
+using Path = tc::stdfs::path;
+using ExportOptions = tc::file_as_img::ExportOptions;
+
+const double dpis[] = {72.0, 150.0, 300.0};
+const double defaultDpi = 96.0;
+
+struct Document
+{
+	Path file;
+	std::string fileFormat;
+
+	bool isPdf() const {
+		return fileFormat == "pdf";
+	}
+};
+
+///@brief argb32 page rendered by backend of document, as it is passed to encoders.
+struct Page
+{
+	std::unique_ptr<tc::file_as_img::mem::IImage> image;
+	//Pdf pages are flattened over white and encoded without alpha channel, as by VSQtPdfManager.
+	bool alpha;
+};
+
+std::vector<Document> corpusOf(const Path& directory)
+{
+	std::vector<Document> documents;
+	for(const auto& entry : tc::stdfs::directory_iterator(directory))
+	{
+		std::string fileFormat = entry.path().extension().string();
+		fileFormat = fileFormat.empty() ? fileFormat : fileFormat.substr(1);
+		if(fileFormat == "pdf" || VSAsposeSlidesManager::supportedFileFormats.count(fileFormat)) {
+			documents.push_back({entry.path(), fileFormat});
+		}
+	}
+	std::sort(documents.begin(), documents.end(), [](const Document& lhs, const Document& rhs) {
+		return lhs.file < rhs.file;
+	});
+	return documents;
+}
+
+std::unique_ptr<QPdfDocument> loadPdf(const Path& file)
+{
+	auto doc = std::make_unique<QPdfDocument>();
+	QPdfDocument::DocumentError err = doc->load(QString::fromStdString(file.string()));
+	if(err != decltype(err)::NoError) {
+		throw std::runtime_error("QPdfDocument load error " + std::to_string(err));
+	}
+	return doc;
+}
+
+assys::SharedPtr<as::Presentation> loadSlides(const Document& document)
+{
+	return assys::MakeObject<as::Presentation>(
+		assys::String::FromUtf8(document.file.string()),
+		assys::MakeObject<as::LoadOptions>(VSAsposeSlidesManager::supportedFileFormats.at(document.fileFormat))
+	);
+}
+
+ExportOptions optionsAt(double dpi)
+{
+	ExportOptions options;
+	options.dpi = dpi;
+	return options;
+}
+
+QImage renderPdfPage(QPdfDocument& doc, double dpi)
+{
+	QSizeF pageSize = doc.pageSize(0);
+	auto [width, height] = tc::file_as_img::pixelSizeOf(optionsAt(dpi), pageSize.width(), pageSize.height());
+	QImage image = doc.render(0, QSize(width, height));
+	if(image.isNull()) {
+		throw std::runtime_error("Unable to render pdf page");
+	}
+	return image;
+}
+
+assys::SharedPtr<assys::Drawing::Bitmap> renderSlide(as::Presentation& pres, double dpi)
+{
+	auto slideSize = pres.get_SlideSize()->get_Size();
+	auto [width, height] = tc::file_as_img::pixelSizeOf(optionsAt(dpi), slideSize.get_Width(), slideSize.get_Height());
+	return pres.get_Slides()->idx_get(0)->GetThumbnail(assys::Drawing::Size(width, height));
+}
+
+///@brief Renders the first page of @p document by its backend as it is rendered for export.
+Page pageOf(const Document& document)
+{
+	ExportOptions options = optionsAt(defaultDpi);
+	options.pages = tc::file_as_img::PageSet::parse("0");
+	Page page{nullptr, !document.isPdf()};
+	auto keep = [&page](std::unique_ptr<tc::file_as_img::mem::IImage> image) {
+		page.image = std::move(image);
+	};
+	if(document.isPdf())
+	{
+		VSQtPdfManager manager;
+		static_cast<tc::file_as_img::mem::IExporter&>(manager).exportAsImages(
+			document.file, document.fileFormat, "argb32", options, keep
+		);
+	}
+	else
+	{
+		VSAsposeSlidesManager manager;
+		static_cast<tc::file_as_img::mem::IExporter&>(manager).exportAsImages(
+			document.file, document.fileFormat, "argb32", options, keep
+		);
+	}
+	if(!page.image) {
+		throw std::runtime_error("Document has no pages " + document.file.string());
+	}
+	return page;
+}
+
+void setPixelsProcessed(benchmark::State& state, std::size_t width, std::size_t height)
+{
+	state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * width * height * 4));
+	state.counters["pixels"] = static_cast<double>(width * height);
+}
+
+void loadBenchmark(benchmark::State& state, const Document& document)
+{
+	for(auto _ : state)
+	{
+		if(document.isPdf()) {
+			benchmark::DoNotOptimize(loadPdf(document.file));
+		}
+		else {
+			benchmark::DoNotOptimize(loadSlides(document));
+		}
+	}
+}
+
+void renderBenchmark(benchmark::State& state, const Document& document, double dpi)
+{
+	std::size_t width = 0;
+	std::size_t height = 0;
+	if(document.isPdf())
+	{
+		auto doc = loadPdf(document.file);
+		for(auto _ : state)
+		{
+			QImage image = renderPdfPage(*doc, dpi);
+			width = image.width();
+			height = image.height();
+		}
+	}
+	else
+	{
+		auto pres = loadSlides(document);
+		for(auto _ : state)
+		{
+			auto bitmap = renderSlide(*pres, dpi);
+			width = bitmap->get_Width();
+			height = bitmap->get_Height();
+		}
+	}
+	setPixelsProcessed(state, width, height);
+}
+
+void flattenBenchmark(benchmark::State& state, const Document& document, bool inPlace)
+{
+	//Format_ARGB32 with straight alpha, as QPdfDocument::render returns it to VSQtPdfManager.
+	QImage rendered = renderPdfPage(*loadPdf(document.file), defaultDpi);
+	for(auto _ : state)
+	{
+		if(inPlace)
+		{
+			//Flattening overwrites page, so every iteration gets its own copy, which is not measured.
+			state.PauseTiming();
+			QImage img = rendered.copy();
+			state.ResumeTiming();
+			VSQtPdfManager::flattenOver(img, 0xFFFFFF);
+			benchmark::DoNotOptimize(img.constBits());
+		}
+		else
+		{
+			//Composite of VSQtPdfManager before flattening in place.
+			QImage img(rendered.size(), rendered.format());
+			img.fill(Qt::white);
+			QPainter p(&img);
+			p.setCompositionMode(QPainter::CompositionMode_SourceAtop);
+			p.drawImage(0, 0, rendered);
+			benchmark::DoNotOptimize(img.constBits());
+		}
+		benchmark::ClobberMemory();
+	}
+	setPixelsProcessed(state, rendered.width(), rendered.height());
+}
+
+void convertBenchmark(benchmark::State& state, const Document& document, const std::string& pixelFormat)
+{
+	const tc::pixel::Kernels& kernels = tc::pixel::kernels();
+	auto convertRow = pixelFormat == "rgba8888" ? kernels.argb32ToRgba8888 : kernels.argb32ToRgb888;
+	std::size_t bytesPerPixel = tc::file_as_img::mem::bytesPerPixelOf(pixelFormat);
+	std::vector<std::uint8_t> converted;
+	if(document.isPdf())
+	{
+		QImage image = renderPdfPage(*loadPdf(document.file), defaultDpi);
+		image.convertTo(QImage::Format_ARGB32);
+		converted.resize(image.width() * bytesPerPixel * image.height());
+		for(auto _ : state)
+		{
+			for(int y = 0; y < image.height(); ++y)
+			{
+				convertRow(
+					reinterpret_cast<const std::uint32_t*>(image.constScanLine(y)),
+					converted.data() + y * image.width() * bytesPerPixel, image.width()
+				);
+			}
+			benchmark::ClobberMemory();
+		}
+		setPixelsProcessed(state, image.width(), image.height());
+		return;
+	}
+	namespace dr = assys::Drawing;
+	auto bitmap = renderSlide(*loadSlides(document), defaultDpi);
+	std::size_t width = bitmap->get_Width();
+	std::size_t height = bitmap->get_Height();
+	converted.resize(width * bytesPerPixel * height);
+	for(auto _ : state)
+	{
+		auto bitmapData = bitmap->LockBits(
+			dr::Rectangle({0, 0}, bitmap->get_Size()), dr::Imaging::ImageLockMode::ReadOnly, dr::Imaging::PixelFormat::Format32bppArgb
+		);
+		const auto* scan0 = reinterpret_cast<const std::uint8_t*>(bitmapData->get_Scan0());
+		for(std::size_t y = 0; y < height; ++y)
+		{
+			convertRow(
+				reinterpret_cast<const std::uint32_t*>(scan0 + static_cast<std::ptrdiff_t>(y) * bitmapData->get_Stride()),
+				converted.data() + y * width * bytesPerPixel, width
+			);
+		}
+		bitmap->UnlockBits(bitmapData);
+		benchmark::ClobberMemory();
+	}
+	setPixelsProcessed(state, width, height);
+}
+
+void encodeBenchmark(benchmark::State& state, const Page& page, const std::string& imageFormat)
+{
+	const auto& image = *page.image;
+	ExportOptions options;
+	std::size_t encodedBytes = 0;
+	tc::file_as_img::enc::Sink sink = [&encodedBytes](const std::uint8_t*, std::size_t size) {
+		encodedBytes += size;
+	};
+	for(auto _ : state)
+	{
+		encodedBytes = 0;
+		tc::file_as_img::enc::encode(
+			reinterpret_cast<const std::uint8_t*>(image.data()), image.width(), image.height(),
+			static_cast<std::ptrdiff_t>(image.stride()), page.alpha, imageFormat, options, sink
+		);
+	}
+	setPixelsProcessed(state, image.width(), image.height());
+	state.counters["encoded_bytes"] = static_cast<double>(encodedBytes);
+}
+
+void registerBenchmarks(const Path& corpusDirectory)
+{
+	auto documents = std::make_shared<std::vector<Document>>(corpusOf(corpusDirectory));
+	if(documents->empty()) {
+		throw std::runtime_error("No documents in corpus " + corpusDirectory.string());
+	}
+	for(const Document& document : *documents)
+	{
+		std::string name = document.file.filename().string();
+		benchmark::RegisterBenchmark(("Load/" + name).c_str(), loadBenchmark, document)
+			->Unit(benchmark::kMillisecond);
+		for(double dpi : dpis)
+		{
+			benchmark::RegisterBenchmark(
+				("Render/" + name + "/" + std::to_string(static_cast<int>(dpi))).c_str(), renderBenchmark, document, dpi
+			)->Unit(benchmark::kMillisecond);
+		}
+		if(document.isPdf())
+		{
+			for(bool inPlace : {false, true})
+			{
+				benchmark::RegisterBenchmark(
+					("Flatten/" + name + "/" + (inPlace ? "inplace" : "qpainter")).c_str(), flattenBenchmark, document, inPlace
+				)->Unit(benchmark::kMicrosecond);
+			}
+		}
+		for(const char* pixelFormat : {"rgba8888", "rgb888"})
+		{
+			benchmark::RegisterBenchmark(
+				("Convert/" + name + "/" + pixelFormat).c_str(), convertBenchmark, document, std::string(pixelFormat)
+			)->Unit(benchmark::kMicrosecond);
+		}
+		//Page is rendered once and shared by encode benchmarks of document.
+		auto page = std::make_shared<Page>(pageOf(document));
+		for(const char* imageFormat : {"png", "jpeg"})
+		{
+			benchmark::RegisterBenchmark(
+				("Encode/" + name + "/" + imageFormat).c_str(),
+				[page, imageFormat](benchmark::State& state) {
+					encodeBenchmark(state, *page, imageFormat);
+				}
+			)->Unit(benchmark::kMillisecond);
+		}
+	}
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<char*> args(argv, argv + argc);
+	std::string jsonFormat = "--benchmark_format=json";
+	bool formatGiven = std::any_of(args.begin(), args.end(), [](const char* arg) {
+		return std::strncmp(arg, "--benchmark_format", std::strlen("--benchmark_format")) == 0;
+	});
+	if(!formatGiven) {
+		args.insert(args.begin() + 1, jsonFormat.data());
+	}
+	int argCount = static_cast<int>(args.size());
+	benchmark::Initialize(&argCount, args.data());
+	if(argCount > 2)
+	{
+		std::cerr << "Usage: " << args[0] << " [benchmark options] [corpus directory]" << std::endl;
+		return 1;
+	}
+	try {
+		registerBenchmarks(argCount == 2 ? Path(args[1]) : Path(VS_BENCHMARK_CORPUS));
+	}
+	catch(std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 2;
+	}
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
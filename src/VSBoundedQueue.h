@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace tc
+{
+
+///@brief Thread safe FIFO queue which blocks producers while it holds @p capacity elements.
+/// After close() producers are rejected and consumers receive remaining elements only.
+template<typename T>
+class BoundedQueue
+{
+public:
+	enum class Status
+	{
+		Ok,
+		Timeout,
+		Closed
+	};
+
+	explicit BoundedQueue(std::size_t capacity) : m_capacity(capacity) {
+		assert(capacity > 0);
+	}
+	BoundedQueue(const BoundedQueue&) = delete;
+	BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+	///@return false if queue has been closed and @p value has not been pushed.
+	bool push(T value)
+	{
+		std::unique_lock lock(m_mutex);
+		m_notFull.wait(lock, [this] { return m_closed || m_values.size() < m_capacity; });
+		if(m_closed) {
+			return false;
+		}
+		m_values.push_back(std::move(value));
+		m_notEmpty.notify_one();
+		return true;
+	}
+
+	///@return std::nullopt if queue has been closed and is empty.
+	std::optional<T> pop()
+	{
+		std::unique_lock lock(m_mutex);
+		m_notEmpty.wait(lock, [this] { return m_closed || !m_values.empty(); });
+		return takeFront();
+	}
+
+	template<typename Rep, typename Period>
+	Status popFor(T& value, const std::chrono::duration<Rep, Period>& timeout)
+	{
+		std::unique_lock lock(m_mutex);
+		if(!m_notEmpty.wait_for(lock, timeout, [this] { return m_closed || !m_values.empty(); })) {
+			return Status::Timeout;
+		}
+		std::optional<T> front = takeFront();
+		if(!front) {
+			return Status::Closed;
+		}
+		value = std::move(*front);
+		return Status::Ok;
+	}
+
+	void close()
+	{
+		std::lock_guard lock(m_mutex);
+		m_closed = true;
+		m_notEmpty.notify_all();
+		m_notFull.notify_all();
+	}
+
+private:
+	std::optional<T> takeFront()
+	{
+		if(m_values.empty()) {
+			return std::nullopt;
+		}
+		std::optional<T> front(std::move(m_values.front()));
+		m_values.pop_front();
+		m_notFull.notify_one();
+		return front;
+	}
+
+	std::mutex m_mutex;
+	std::condition_variable m_notEmpty;
+	std::condition_variable m_notFull;
+	std::deque<T> m_values;
+	std::size_t m_capacity;
+	bool m_closed = false;
+};
+
+} //namespace tc
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "VSBufferPool.h"
+
+#include <iterator>
+#include <utility>
+
+namespace tc::file_as_img::mem
+{
+
+void BufferPool::Releaser::operator()(Byte* data) const
+{
+	if(!data) {
+		return;
+	}
+	if(std::shared_ptr<BufferPool> pool = m_pool.lock()) {
+		pool->release(data, m_capacity);
+	}
+	else {
+		delete[] data;
+	}
+}
+
+BufferPool::BufferPool(std::size_t maxIdleBytes) : m_maxIdleBytes(maxIdleBytes)
+{}
+
+auto BufferPool::acquire(std::size_t size) -> Buffer
+{
+	std::unique_ptr<Byte[]> data;
+	std::size_t capacity = size;
+	{
+		std::lock_guard lock(m_mutex);
+		auto idle = m_idle.lower_bound(size);
+		if(idle != m_idle.end() && idle->first / 2 <= size)
+		{
+			++m_hits;
+			capacity = idle->first;
+			data = std::move(idle->second);
+			m_idleBytes -= capacity;
+			m_idle.erase(idle);
+		}
+		else {
+			++m_misses;
+		}
+	}
+	if(!data) {
+		data.reset(new Byte[capacity]);
+	}
+	return Buffer(data.release(), Releaser(weak_from_this(), capacity));
+}
+
+auto BufferPool::stats() const -> Stats
+{
+	std::lock_guard lock(m_mutex);
+	return {m_hits, m_misses, m_idle.size(), m_idleBytes};
+}
+
+void BufferPool::setMaxIdleBytes(std::size_t maxIdleBytes)
+{
+	Idle freed;
+	std::lock_guard lock(m_mutex);
+	m_maxIdleBytes = maxIdleBytes;
+	trim(freed);
+}
+
+void BufferPool::clear()
+{
+	Idle freed;
+	std::lock_guard lock(m_mutex);
+	freed.swap(m_idle);
+	m_idleBytes = 0;
+}
+
+void BufferPool::release(Byte* data, std::size_t capacity)
+{
+	Idle freed;
+	std::unique_ptr<Byte[]> buffer(data);
+	std::lock_guard lock(m_mutex);
+	m_idle.emplace(capacity, std::move(buffer));
+	m_idleBytes += capacity;
+	trim(freed);
+}
+
+void BufferPool::trim(Idle& freed)
+{
+	while(m_idleBytes > m_maxIdleBytes && !m_idle.empty())
+	{
+		auto largest = std::prev(m_idle.end());
+		m_idleBytes -= largest->first;
+		freed.insert(m_idle.extract(largest));
+	}
+}
+
+} //namespace tc::file_as_img::mem
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace tc::file_as_img::mem
+{
+
+///@brief Thread safe pool of large pixel buffers reused by in-memory exporters.
+///
+/// Buffers are handed out as unique pointers which return storage to the pool on destruction, so images dropped
+/// by consumer feed allocation of the next page and steady-state export of pages of equal size allocates nothing.
+/// Buffer is reused for requests of at least half of its capacity. Idle buffers over limit are freed,
+/// largest first. Buffers return to the pool only while it is owned by std::shared_ptr, otherwise they are freed.
+class BufferPool : public std::enable_shared_from_this<BufferPool>
+{
+public:
+	using Byte = std::byte;
+
+	struct Stats
+	{
+		std::size_t hits = 0;
+		std::size_t misses = 0;
+		std::size_t idleBuffers = 0;
+		std::size_t idleBytes = 0;
+	};
+
+	class Releaser
+	{
+	public:
+		Releaser() = default;
+		void operator()(Byte* data) const;
+
+	private:
+		friend class BufferPool;
+		Releaser(std::weak_ptr<BufferPool> pool, std::size_t capacity) : m_pool(std::move(pool)), m_capacity(capacity)
+		{}
+
+		std::weak_ptr<BufferPool> m_pool;
+		std::size_t m_capacity = 0;
+	};
+
+	using Buffer = std::unique_ptr<Byte[], Releaser>;
+
+	static constexpr std::size_t defaultMaxIdleBytes = std::size_t(256) << 20;
+
+	explicit BufferPool(std::size_t maxIdleBytes);
+	BufferPool(const BufferPool&) = delete;
+	BufferPool& operator=(const BufferPool&) = delete;
+
+	///@return uninitialized buffer of at least @p size bytes.
+	Buffer acquire(std::size_t size);
+
+	Stats stats() const;
+	void setMaxIdleBytes(std::size_t maxIdleBytes);
+	///@brief Frees idle buffers, buffers in use return to pool as usual.
+	void clear();
+
+private:
+	using Idle = std::multimap<std::size_t, std::unique_ptr<Byte[]>>;
+
+	void release(Byte* data, std::size_t capacity);
+	///@pre m_mutex is locked.
+	void trim(Idle& freed);
+
+	mutable std::mutex m_mutex;
+	Idle m_idle;
+	std::size_t m_maxIdleBytes;
+	std::size_t m_idleBytes = 0;
+	std::size_t m_hits = 0;
+	std::size_t m_misses = 0;
+};
+
+} //namespace tc::file_as_img::mem
\ No newline at end of file
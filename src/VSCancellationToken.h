@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+#include "VSUtils.h"
+
+namespace tc::file_as_img
+{
+
+///@brief Shared cancellation flag with optional deadline, copies of token share their state.
+/// Child token is cancelled with its parent and expires at the earliest deadline of its ancestors,
+/// so cancelling batch token cancels tokens of all its documents and their pages, but not the other way round.
+/// Default constructed token is a root which is never cancelled unless cancel() is called on it.
+class CancellationToken
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	CancellationToken() : m_state(std::make_shared<State>(nullptr, Clock::time_point::max()))
+	{}
+
+	///@brief Cancels this token and its children, thread safe.
+	void cancel() {
+		m_state->cancelled = true;
+	}
+
+	///@return true if this token or any of its ancestors has been cancelled.
+	bool isCancelled() const
+	{
+		for(const State* state = m_state.get(); state; state = state->parent.get())
+		{
+			if(state->cancelled) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	///@return the earliest deadline of this token and its ancestors, Clock::time_point::max() if there is none.
+	Clock::time_point deadline() const {
+		return m_state->deadline;
+	}
+
+	bool isExpired() const {
+		return deadline() != Clock::time_point::max() && Clock::now() >= deadline();
+	}
+
+	///@throw tc::err::exc::Interrupted if token has been cancelled.
+	///@throw tc::err::exc::Timeout if deadline has passed.
+	void check() const
+	{
+		if(isCancelled()) {
+			throw tc::err::exc::Interrupted();
+		}
+		if(isExpired()) {
+			throw tc::err::exc::Timeout();
+		}
+	}
+
+	///@return token cancelled by this token, which is cancelled by its own cancel() independently of this token.
+	CancellationToken child() const {
+		return CancellationToken(std::make_shared<State>(m_state, m_state->deadline));
+	}
+
+	///@return child token expiring after @p budget from now, non positive @p budget keeps deadline of this token.
+	CancellationToken withTimeout(Clock::duration budget) const
+	{
+		Clock::time_point deadline = m_state->deadline;
+		if(budget > Clock::duration::zero()) {
+			deadline = std::min(deadline, Clock::now() + budget);
+		}
+		return CancellationToken(std::make_shared<State>(m_state, deadline));
+	}
+
+private:
+	struct State
+	{
+		State(std::shared_ptr<const State> parent, Clock::time_point deadline) :
+			parent(std::move(parent)), deadline(deadline)
+		{}
+
+		std::atomic_bool cancelled = false;
+		//Parent and deadline are immutable, so they are read without synchronization.
+		const std::shared_ptr<const State> parent;
+		const Clock::time_point deadline;
+	};
+
+	explicit CancellationToken(std::shared_ptr<State> state) : m_state(std::move(state))
+	{}
+
+	std::shared_ptr<State> m_state;
+};
+
+} //namespace tc::file_as_img
@@ -0,0 +1,134 @@
+#include "VSConverter.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "VSExportPipeline.h"
+#include "VSImageEncoder.h"
+
+auto VSConverter::exporterFor(const FileFormat& fileFormat) -> Exporter&
+{
+	if(fileFormat == "pdf") {
+		return m_cachingPdfExporter ? static_cast<Exporter&>(*m_cachingPdfExporter) : m_pdfManager;
+	}
+	return m_cachingSlidesExporter ? static_cast<Exporter&>(*m_cachingSlidesExporter) : m_slidesManager;
+}
+
+auto VSConverter::memExporterFor(const FileFormat& fileFormat) -> MemExporter&
+{
+	if(fileFormat == "pdf") {
+		return m_pdfManager;
+	}
+	return m_slidesManager;
+}
+
+auto VSConverter::thumbnailGeneratorFor(const FileFormat& fileFormat) -> ThumbnailGenerator&
+{
+	if(fileFormat == "pdf") {
+		return m_pdfManager;
+	}
+	return m_slidesManager;
+}
+
+void VSConverter::convert(const Job& job, const AnyImageNameConsumer& forEachImageName)
+{
+	exporterFor(job.fileFormat).exportAsImages(
+		job.file,
+		job.fileFormat,
+		job.outputDir,
+		job.imageFormat,
+		[&job, generator = tc::file_as_img::fs::IncrementNameGenerator(0, "." + job.imageFormat)]() mutable {
+			return job.imagePrefix + generator();
+		},
+		job.options,
+		forEachImageName
+	);
+}
+
+auto VSConverter::thumbnail(const Job& job) -> String
+{
+	return thumbnailGeneratorFor(job.fileFormat).generateThumbnail(
+		job.file,
+		job.fileFormat,
+		job.outputDir,
+		job.imageFormat,
+		[&job, generator = tc::file_as_img::fs::IncrementNameGenerator(0, "." + job.imageFormat)]() mutable {
+			return job.imagePrefix + generator();
+		},
+		job.options
+	);
+}
+
+void VSConverter::stream(const Job& job, VSFrameWriter& writer)
+{
+	if(!tc::file_as_img::enc::isEncoded(job.imageFormat)) {
+		throw tc::file_as_img::InvalidImageFormat("Image format " + job.imageFormat + " can not be streamed");
+	}
+	using Image = std::unique_ptr<tc::file_as_img::mem::IImage>;
+	using Encoded = std::vector<std::uint8_t>;
+	//Pdf pages are flattened over background, slides keep alpha channel as they do in image files.
+	bool alpha = job.fileFormat != "pdf";
+	//Image indices are passed through pipeline as names.
+	tc::file_as_img::fs::ExportPipeline<Image, Encoded> pipeline(
+		std::max<std::size_t>(1, job.options.pipelineDepth),
+		[&job, alpha](Image& image) {
+			Encoded bytes;
+			tc::file_as_img::enc::encode(
+				reinterpret_cast<const std::uint8_t*>(image->data()), image->width(), image->height(),
+				static_cast<std::ptrdiff_t>(image->stride()), alpha, job.imageFormat, job.options,
+				[&bytes](const std::uint8_t* data, std::size_t size) {
+					bytes.insert(bytes.end(), data, data + size);
+				}
+			);
+			return bytes;
+		},
+		[&job, &writer](const Encoded& bytes, const String& index) {
+			writer.write(static_cast<std::uint32_t>(std::stoul(index)), job.imageFormat, bytes.data(), bytes.size());
+		},
+		[](const String&) {}
+	);
+	std::uint32_t index = 0;
+	memExporterFor(job.fileFormat).exportAsImages(
+		job.file, job.fileFormat, "argb32", job.options,
+		[&pipeline, &index](Image image) {
+			pipeline.push(std::move(image), std::to_string(index++));
+		}
+	);
+	pipeline.finish();
+}
+
+void VSConverter::setInterrupt(bool interrupt)
+{
+	for(Exporter* exporter : {static_cast<Exporter*>(&m_pdfManager), static_cast<Exporter*>(&m_slidesManager)}) {
+		exporter->setInterruptFor(tc::file_as_img::taskOf<tc::file_as_img::fs::IExporter>, interrupt);
+	}
+	for(MemExporter* exporter : {static_cast<MemExporter*>(&m_pdfManager), static_cast<MemExporter*>(&m_slidesManager)}) {
+		exporter->setInterruptFor(tc::file_as_img::taskOf<tc::file_as_img::mem::IExporter>, interrupt);
+	}
+	for(ThumbnailGenerator* generator : {
+		static_cast<ThumbnailGenerator*>(&m_pdfManager), static_cast<ThumbnailGenerator*>(&m_slidesManager)
+	}) {
+		generator->setInterruptFor(tc::file_as_img::taskOf<tc::file_as_img::fs::IThumbnailGenerator>, interrupt);
+	}
+}
+
+void VSConverter::setDocumentCache(std::shared_ptr<tc::file_as_img::DocumentCache> cache)
+{
+	m_pdfManager.setDocumentCache(cache);
+	m_slidesManager.setDocumentCache(std::move(cache));
+}
+
+void VSConverter::setRenderCache(std::shared_ptr<tc::file_as_img::fs::RenderCache> cache)
+{
+	using tc::file_as_img::fs::CachingExporter;
+	m_cachingPdfExporter.reset();
+	m_cachingSlidesExporter.reset();
+	if(cache)
+	{
+		m_cachingPdfExporter = std::make_unique<CachingExporter>(m_pdfManager, VSQtPdfManager::backendVersion(), cache);
+		m_cachingSlidesExporter = std::make_unique<CachingExporter>(
+			m_slidesManager, VSAsposeSlidesManager::backendVersion(), std::move(cache)
+		);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <functional>
+
+#include "VSExportFileAsImages.h"
+#include "VSExportOptions.h"
+#include "VSFrameWriter.h"
+#include "VSAsposeSlidesManager.h"
+#include "VSQtPdfManager.h"
+#include "VSRenderCache.h"
+
+///@brief Owns one instance of every backend and routes file conversions to the backend supporting file format.
+/// Can be used from several threads at once, interrupt affects all conversions running on the instance.
+class VSConverter
+{
+public:
+	using Path = tc::file_as_img::fs::TypesHolder::Path;
+	using FileFormat = tc::file_as_img::fs::TypesHolder::FileFormat;
+	using ImageFormat = tc::file_as_img::fs::TypesHolder::ImageFormat;
+	using String = tc::file_as_img::fs::TypesHolder::String;
+	using ExportOptions = tc::file_as_img::ExportOptions;
+	using Exporter = tc::file_as_img::IInterruptible<tc::file_as_img::fs::IExporter>;
+	using MemExporter = tc::file_as_img::IInterruptible<tc::file_as_img::mem::IExporter>;
+	using ThumbnailGenerator = tc::file_as_img::IInterruptible<tc::file_as_img::fs::IThumbnailGenerator>;
+	using AnyImageNameConsumer = tc::file_as_img::fs::IExporter::AnyImageNameConsumer;
+
+	struct Job
+	{
+		Path file;
+		FileFormat fileFormat;
+		Path outputDir = ".";
+		ImageFormat imageFormat = "png";
+		///@brief Prepended to names of produced images, so jobs sharing output directory do not overwrite each other.
+		String imagePrefix;
+		ExportOptions options;
+	};
+
+	VSConverter() = default;
+	VSConverter(const VSConverter&) = delete;
+	VSConverter& operator=(const VSConverter&) = delete;
+
+	Exporter& exporterFor(const FileFormat& fileFormat);
+	MemExporter& memExporterFor(const FileFormat& fileFormat);
+	ThumbnailGenerator& thumbnailGeneratorFor(const FileFormat& fileFormat);
+
+	///@brief Exports file of @p job to images named <imagePrefix>0.<imageFormat>, <imagePrefix>1.<imageFormat>, ...
+	/// in output directory.
+	///@throw exceptions of exporter.
+	void convert(const Job& job, const AnyImageNameConsumer& forEachImageName);
+
+	///@brief Generates thumbnail of the first selected page of file of @p job named <imagePrefix>0.<imageFormat>
+	/// in output directory. Thumbnails are rendered every time, so render cache is not used.
+	///@return name of thumbnail.
+	///@throw exceptions of thumbnail generator.
+	String thumbnail(const Job& job);
+
+	///@brief Exports file of @p job to frames of @p writer instead of files, output directory is ignored.
+	/// Pages are rendered in memory, so render cache is not used.
+	///@throw InvalidImageFormat if image format is not encoded by this library.
+	///@throw exceptions of exporter, encoder and @p writer.
+	void stream(const Job& job, VSFrameWriter& writer);
+
+	void setInterrupt(bool interrupt);
+
+	///@brief Shares @p cache of loaded documents between all backends, nullptr disables caching.
+	void setDocumentCache(std::shared_ptr<tc::file_as_img::DocumentCache> cache);
+
+	///@brief Serves pages of all backends from @p cache of rendered images, nullptr disables caching.
+	/// Not thread safe relative to conversions.
+	void setRenderCache(std::shared_ptr<tc::file_as_img::fs::RenderCache> cache);
+
+private:
+	VSQtPdfManager m_pdfManager;
+	VSAsposeSlidesManager m_slidesManager;
+	std::unique_ptr<tc::file_as_img::fs::CachingExporter> m_cachingPdfExporter;
+	std::unique_ptr<tc::file_as_img::fs::CachingExporter> m_cachingSlidesExporter;
+};
\ No newline at end of file
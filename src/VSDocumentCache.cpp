@@ -0,0 +1,98 @@
+#include "VSDocumentCache.h"
+
+#include <cassert>
+#include <iterator>
+
+namespace tc::file_as_img
+{
+
+DocumentCache::DocumentCache(std::size_t memoryBudget) : m_memoryBudget(memoryBudget)
+{}
+
+auto DocumentCache::keyOf(const Path& file, const std::string& backend) -> std::optional<Key>
+{
+	std::error_code err;
+	Path canonical = tc::stdfs::canonical(file, err);
+	if(err) {
+		return std::nullopt;
+	}
+	auto mtime = tc::stdfs::last_write_time(canonical, err);
+	if(err) {
+		return std::nullopt;
+	}
+	auto size = tc::stdfs::file_size(canonical, err);
+	if(err) {
+		return std::nullopt;
+	}
+	return backend + '\n' + canonical.string() + '\n' +
+		std::to_string(mtime.time_since_epoch().count()) + '\n' + std::to_string(size);
+}
+
+void DocumentCache::setMemoryBudget(std::size_t memoryBudget)
+{
+	Entries evicted;
+	std::lock_guard lock(m_mutex);
+	m_memoryBudget = memoryBudget;
+	evict(m_memoryBudget, evicted);
+}
+
+std::size_t DocumentCache::memoryBudget() const
+{
+	std::lock_guard lock(m_mutex);
+	return m_memoryBudget;
+}
+
+std::size_t DocumentCache::memoryUsage() const
+{
+	std::lock_guard lock(m_mutex);
+	return m_memoryUsage;
+}
+
+void DocumentCache::clear()
+{
+	Entries evicted;
+	std::lock_guard lock(m_mutex);
+	evict(0, evicted);
+}
+
+std::any DocumentCache::takeAny(const Key& key)
+{
+	std::lock_guard lock(m_mutex);
+	auto it = m_index.find(key);
+	if(it == m_index.end()) {
+		return {};
+	}
+	Entry entry = std::move(*it->second);
+	m_entries.erase(it->second);
+	m_index.erase(it);
+	m_memoryUsage -= entry.cost;
+	return std::move(entry.document);
+}
+
+void DocumentCache::putAny(const Key& key, std::any document, std::size_t cost)
+{
+	//documents are destroyed after the mutex is unlocked, as destruction may lock backend mutexes.
+	Entries evicted;
+	std::lock_guard lock(m_mutex);
+	if(cost > m_memoryBudget || m_index.count(key)) {
+		evicted.push_back({key, std::move(document), cost});
+		return;
+	}
+	evict(m_memoryBudget - cost, evicted);
+	m_entries.push_front({key, std::move(document), cost});
+	m_index.emplace(key, m_entries.begin());
+	m_memoryUsage += cost;
+}
+
+void DocumentCache::evict(std::size_t memoryBudget, Entries& evicted)
+{
+	while(m_memoryUsage > memoryBudget)
+	{
+		assert(!m_entries.empty());
+		m_index.erase(m_entries.back().key);
+		m_memoryUsage -= m_entries.back().cost;
+		evicted.splice(evicted.begin(), m_entries, std::prev(m_entries.end()));
+	}
+}
+
+} //namespace tc::file_as_img
\ No newline at end of file
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <any>
+#include <cassert>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+
+#include "VSNamespace.h"
+
+namespace tc::file_as_img
+{
+
+///@brief Size bounded LRU cache of parsed documents, which can be shared by backends across calls.
+///
+/// Documents are keyed by canonical path, modification time and size of file together with backend name.
+/// Document is checked out exclusively: take() removes it from the cache and put() returns it back, so one
+/// document is never used by two threads at once, concurrent users of the same file load their own copies.
+/// Memory cost of document is estimated by size of its file, documents which do not fit into budget are not cached.
+class DocumentCache
+{
+public:
+	using Path = tc::stdfs::path;
+	using Key = std::string;
+
+	explicit DocumentCache(std::size_t memoryBudget);
+	DocumentCache(const DocumentCache&) = delete;
+	DocumentCache& operator=(const DocumentCache&) = delete;
+
+	///@return key of current state of @p file for @p backend or std::nullopt if file state can not be read.
+	static std::optional<Key> keyOf(const Path& file, const std::string& backend);
+
+	///@return document of type @p Document removed from cache or std::nullopt if cache does not hold it.
+	template<typename Document>
+	std::optional<Document> take(const Key& key)
+	{
+		std::any document = takeAny(key);
+		if(Document* typed = std::any_cast<Document>(&document)) {
+			return std::move(*typed);
+		}
+		return std::nullopt;
+	}
+
+	///@brief Puts @p document to cache as most recently used, evicting least recently used documents over budget.
+	template<typename Document>
+	void put(const Key& key, Document document, std::size_t cost) {
+		putAny(key, std::any(std::move(document)), cost);
+	}
+
+	void setMemoryBudget(std::size_t memoryBudget);
+	std::size_t memoryBudget() const;
+	std::size_t memoryUsage() const;
+	void clear();
+
+private:
+	struct Entry
+	{
+		Key key;
+		std::any document;
+		std::size_t cost;
+	};
+	using Entries = std::list<Entry>;
+
+	std::any takeAny(const Key& key);
+	void putAny(const Key& key, std::any document, std::size_t cost);
+	///@pre m_mutex is locked.
+	void evict(std::size_t memoryBudget, Entries& evicted);
+
+	mutable std::mutex m_mutex;
+	Entries m_entries;
+	std::unordered_map<Key, Entries::iterator> m_index;
+	std::size_t m_memoryBudget;
+	std::size_t m_memoryUsage = 0;
+};
+
+///@brief Holds document taken from cache or loaded and puts it back to cache on destruction.
+template<typename Document>
+class CachedDocument
+{
+public:
+	///@param load is invoked if there is no cache, no key for @p file or cache does not hold document.
+	template<typename Load>
+	CachedDocument(
+		std::shared_ptr<DocumentCache> cache, const DocumentCache::Path& file, const std::string& backend, Load load
+	) : m_cache(std::move(cache))
+	{
+		if(m_cache) {
+			m_key = DocumentCache::keyOf(file, backend);
+		}
+		if(m_key)
+		{
+			std::error_code err;
+			m_cost = static_cast<std::size_t>(tc::stdfs::file_size(file, err));
+			m_document = m_cache->take<Document>(*m_key);
+		}
+		if(!m_document) {
+			m_document = load();
+		}
+	}
+	CachedDocument(const CachedDocument&) = delete;
+	CachedDocument& operator=(const CachedDocument&) = delete;
+
+	~CachedDocument()
+	{
+		if(m_key && m_document) {
+			m_cache->put(*m_key, std::move(*m_document), m_cost);
+		}
+	}
+
+	Document& get() {
+		assert(m_document);
+		return *m_document;
+	}
+
+	///@brief Document will not be returned to cache.
+	void forget() {
+		m_key.reset();
+	}
+
+private:
+	std::shared_ptr<DocumentCache> m_cache;
+	std::optional<DocumentCache::Key> m_key;
+	std::optional<Document> m_document;
+	std::size_t m_cost = 0;
+};
+
+} //namespace tc::file_as_img
\ No newline at end of file
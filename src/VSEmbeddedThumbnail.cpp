@@ -0,0 +1,90 @@
+#include "VSEmbeddedThumbnail.h"
+
+#include <exception>
+#include <regex>
+
+#include "VSImageDecoder.h"
+#include "VSZipReader.h"
+
+namespace tc::file_as_img
+{
+
+namespace
+{
+
+//Larger entries are not previews worth taking instead of rendering.
+constexpr std::size_t maxThumbnailSize = 16 << 20;
+constexpr std::size_t maxRelationshipsSize = 1 << 20;
+
+///@return name of package entry with thumbnail relationship of OOXML package.
+std::optional<std::string> ooxmlThumbnailName(const ZipReader& package)
+{
+	std::optional<std::vector<std::uint8_t>> relationships = package.read("_rels/.rels", maxRelationshipsSize);
+	if(!relationships) {
+		return std::nullopt;
+	}
+	std::string xml(relationships->begin(), relationships->end());
+	static const std::regex relationship("<(?:\\w+:)?Relationship\\s[^>]*>");
+	static const std::regex thumbnailType("\\sType\\s*=\\s*\"[^\"]*/metadata/thumbnail\"");
+	static const std::regex target("\\sTarget\\s*=\\s*\"/?([^\"]+)\"");
+	for(std::sregex_iterator it(xml.begin(), xml.end(), relationship), end; it != end; ++it)
+	{
+		std::string element = it->str();
+		std::smatch match;
+		if(std::regex_search(element, thumbnailType) && std::regex_search(element, match, target)) {
+			return match[1].str();
+		}
+	}
+	return std::nullopt;
+}
+
+std::optional<std::string> imageFormatOf(const std::string& name)
+{
+	std::string extension = tc::stdfs::path(name).extension().string();
+	if(extension == ".jpeg" || extension == ".jpg") {
+		return "jpeg";
+	}
+	if(extension == ".png") {
+		return "png";
+	}
+	return std::nullopt;
+}
+
+}
+
+std::optional<EmbeddedThumbnail> readEmbeddedThumbnail(
+	const TypesHolder::Path& file, const ExportOptions& options, const mem::IImage::PixelFormat& pixelFormat
+)
+{
+	try
+	{
+		ZipReader package(file);
+		std::optional<std::string> name = package.contains("Thumbnails/thumbnail.png")
+			? std::optional<std::string>("Thumbnails/thumbnail.png")
+			: ooxmlThumbnailName(package);
+		std::optional<std::string> imageFormat = name ? imageFormatOf(*name) : std::nullopt;
+		if(!imageFormat) {
+			return std::nullopt;
+		}
+		std::optional<std::vector<std::uint8_t>> bytes = package.read(*name, maxThumbnailSize);
+		if(!bytes || bytes->empty()) {
+			return std::nullopt;
+		}
+		EmbeddedThumbnail thumbnail{std::move(*bytes), *imageFormat, nullptr};
+		thumbnail.image = dec::decode(thumbnail.bytes.data(), thumbnail.bytes.size(), thumbnail.imageFormat, pixelFormat);
+		const BoundingBox& minSize = options.embeddedThumbnail.minSize;
+		if(thumbnail.image->width() < minSize.width || thumbnail.image->height() < minSize.height) {
+			return std::nullopt;
+		}
+		const BoundingBox& box = options.fitWithin;
+		if(!box.empty() && (thumbnail.image->width() > box.width || thumbnail.image->height() > box.height)) {
+			return std::nullopt;
+		}
+		return thumbnail;
+	}
+	catch(const std::exception&) {
+		return std::nullopt;
+	}
+}
+
+} //namespace tc::file_as_img
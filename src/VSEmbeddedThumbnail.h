@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "VSExportFileAsImages.h"
+#include "VSExportOptions.h"
+
+namespace tc::file_as_img
+{
+
+///@brief Preview image stored in OOXML package by relationship of thumbnail type, usually docProps/thumbnail.jpeg,
+/// or in ODF package as Thumbnails/thumbnail.png.
+struct EmbeddedThumbnail
+{
+	///@brief Encoded image as stored in package.
+	std::vector<std::uint8_t> bytes;
+	///@brief "png" or "jpeg".
+	std::string imageFormat;
+	std::unique_ptr<mem::Image> image;
+};
+
+///@brief Reads and decodes embedded preview of package @p file to @p pixelFormat without loading the document.
+///@return nullopt if @p file is not zip package, has no png or jpeg preview, preview is corrupted,
+/// smaller than options.embeddedThumbnail.minSize or does not fit in options.fitWithin.
+std::optional<EmbeddedThumbnail> readEmbeddedThumbnail(
+	const TypesHolder::Path& file, const ExportOptions& options, const mem::IImage::PixelFormat& pixelFormat
+);
+
+} //namespace tc::file_as_img
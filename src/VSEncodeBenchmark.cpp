@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "VSAsposeSlidesManager.h"
+#include "VSExportOptions.h"
+#include "VSJpegEncoder.h"
+#include "VSPngEncoder.h"
+#include "VSQtPdfManager.h"
+#include "VSWebpEncoder.h"
+
+//Renders every document of corpus directory to argb32 pages once, then encodes all pages by every encoder preset
+//and reports encoding throughput in MB/s of raw pixels and total size of produced files relative to default png.
+
+namespace
+{
+
+using IImage = tc::file_as_img::mem::IImage;
+using PngOptions = tc::file_as_img::PngOptions;
+
+struct Page
+{
+	std::unique_ptr<IImage> image;
+	//Pdf pages are flattened over white and encoded without alpha channel, as by VSQtPdfManager.
+	bool alpha;
+};
+
+using Encode = std::function<void(const Page&, const tc::file_as_img::enc::Sink&)>;
+
+Encode png(PngOptions options)
+{
+	return [options](const Page& page, const tc::file_as_img::enc::Sink& sink) {
+		tc::file_as_img::enc::encodePng(
+			reinterpret_cast<const std::uint8_t*>(page.image->data()), page.image->width(), page.image->height(),
+			static_cast<std::ptrdiff_t>(page.image->stride()), page.alpha, options, sink
+		);
+	};
+}
+
+Encode jpeg(tc::file_as_img::JpegOptions options)
+{
+	return [options](const Page& page, const tc::file_as_img::enc::Sink& sink) {
+		tc::file_as_img::enc::encodeJpeg(
+			reinterpret_cast<const std::uint8_t*>(page.image->data()), page.image->width(), page.image->height(),
+			static_cast<std::ptrdiff_t>(page.image->stride()), options, sink
+		);
+	};
+}
+
+Encode webp(tc::file_as_img::WebpOptions options)
+{
+	return [options](const Page& page, const tc::file_as_img::enc::Sink& sink) {
+		tc::file_as_img::enc::encodeWebp(
+			reinterpret_cast<const std::uint8_t*>(page.image->data()), page.image->width(), page.image->height(),
+			static_cast<std::ptrdiff_t>(page.image->stride()), options, sink
+		);
+	};
+}
+
+///@return presets in order of report, the first one is baseline of relative sizes.
+std::vector<std::pair<std::string, Encode>> presets()
+{
+	std::vector<std::pair<std::string, Encode>> result;
+	result.emplace_back("png", png(PngOptions()));
+	PngOptions level1;
+	level1.compressionLevel = 1;
+	result.emplace_back("png-level1", png(level1));
+	result.emplace_back("png-fast", png(PngOptions::fast()));
+	PngOptions rle = PngOptions::fast();
+	rle.strategy = PngOptions::Strategy::Rle;
+	result.emplace_back("png-rle", png(rle));
+	result.emplace_back("jpeg", jpeg(tc::file_as_img::JpegOptions()));
+	tc::file_as_img::WebpOptions webpOptions;
+	result.emplace_back("webp", webp(webpOptions));
+	webpOptions.method = 0;
+	result.emplace_back("webp-m0", webp(webpOptions));
+	webpOptions.lossless = true;
+	webpOptions.method = 1;
+	webpOptions.quality = 25.0f;
+	result.emplace_back("webp-ll-fast", webp(webpOptions));
+	webpOptions.method = 4;
+	webpOptions.quality = 75.0f;
+	result.emplace_back("webp-ll", webp(webpOptions));
+	return result;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	namespace opt = boost::program_options;
+	opt::options_description options;
+	options.add_options()
+	("corpus", opt::value<std::string>()->default_value("test/input"))
+	("dpi", opt::value<double>()->default_value(96.0))
+	("iterations", opt::value<std::size_t>()->default_value(3));
+	opt::variables_map vars;
+	try {
+		opt::store(opt::parse_command_line(argc, argv, options), vars);
+	}
+	catch(opt::error& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	VSQtPdfManager pdfManager;
+	VSAsposeSlidesManager slidesManager;
+	pdfManager.setBufferPool(nullptr);
+	slidesManager.setBufferPool(nullptr);
+	tc::file_as_img::ExportOptions exportOptions;
+	exportOptions.dpi = vars["dpi"].as<double>();
+
+	std::vector<Page> pages;
+	std::uintmax_t pixelBytes = 0;
+	try
+	{
+		for(const auto& entry : tc::stdfs::directory_iterator(vars["corpus"].as<std::string>()))
+		{
+			std::string fileFormat = entry.path().extension().string();
+			fileFormat = fileFormat.empty() ? fileFormat : fileFormat.substr(1);
+			bool pdf = fileFormat == "pdf";
+			if(!pdf && !VSAsposeSlidesManager::supportedFileFormats.count(fileFormat)) {
+				continue;
+			}
+			tc::file_as_img::mem::IExporter& exporter = pdf
+				? static_cast<tc::file_as_img::mem::IExporter&>(pdfManager)
+				: static_cast<tc::file_as_img::mem::IExporter&>(slidesManager);
+			exporter.exportAsImages(entry.path(), fileFormat, "argb32", exportOptions, [&](std::unique_ptr<IImage> image) {
+				pixelBytes += image->width() * image->height() * image->bytesPerPixel();
+				pages.push_back({std::move(image), !pdf});
+			});
+		}
+	}
+	catch(std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 2;
+	}
+	if(pages.empty())
+	{
+		std::cerr << "No documents in corpus" << std::endl;
+		return 1;
+	}
+	std::cout << pages.size() << " pages, " << (pixelBytes >> 20) << " MB of pixels" << std::endl;
+
+	std::size_t iterations = std::max<std::size_t>(1, vars["iterations"].as<std::size_t>());
+	std::uintmax_t baselineBytes = 0;
+	for(const auto& [name, encode] : presets())
+	{
+		std::uintmax_t encodedBytes = 0;
+		tc::file_as_img::enc::Sink sink = [&encodedBytes](const std::uint8_t*, std::size_t size) {
+			encodedBytes += size;
+		};
+		auto start = std::chrono::steady_clock::now();
+		for(std::size_t i = 0; i < iterations; ++i)
+		{
+			encodedBytes = 0;
+			for(const Page& page : pages) {
+				encode(page, sink);
+			}
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if(baselineBytes == 0) {
+			baselineBytes = encodedBytes;
+		}
+		std::cout << std::left << std::setw(14) << name << std::right << std::fixed << std::setprecision(1)
+			<< std::setw(10) << static_cast<double>(pixelBytes) * iterations / seconds / 1e6 << " MB/s"
+			<< std::setw(14) << encodedBytes << " bytes"
+			<< std::setw(8) << 100.0 * encodedBytes / baselineBytes << " % of png" << std::endl;
+	}
+	return 0;
+}
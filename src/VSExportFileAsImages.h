@@ -1,6 +1,8 @@
 #pragma once
 
 #include <any>
+#include <cassert>
+#include <functional>
 #include <memory>
 #include <type_traits>
 
@@ -114,7 +116,9 @@ namespace mem
 {
 
 //Defined pixel formats:
-//argb32
+//argb32 - 32-bit words 0xAARRGGBB in native byte order, straight alpha;
+//rgba8888 - bytes R, G, B, A, straight alpha;
+//rgb888 - bytes R, G, B.
 
 class IImage;
 
@@ -135,21 +139,59 @@ public:
 	virtual Size width() const = 0;
 	virtual Size height() const = 0;
 	virtual PixelFormat format() const = 0;
+	///@brief First byte of top row, rows are stride() bytes apart and may be padded.
 	virtual const Byte* data() const = 0;
+	virtual Size stride() const = 0;
+	virtual Size bytesPerPixel() const = 0;
 };
 
+///@throw InvalidArgument if @p pixelFormat is not defined.
+inline IImage::Size bytesPerPixelOf(const IImage::PixelFormat& pixelFormat)
+{
+	if(pixelFormat == "argb32" || pixelFormat == "rgba8888") {
+		return 4;
+	}
+	if(pixelFormat == "rgb888") {
+		return 3;
+	}
+	throw tc::err::exc::InvalidArgument("Invalid pixel format");
+}
+
 class Image : public IImage
 {
 public:
-	Image(std::unique_ptr<const Byte> data, Size width, Size height, PixelFormat format)
-		: m_data(std::move(data)), m_width(width), m_height(height), m_format(std::move(format))
+	///@brief Invoked on destruction with data of image to release its memory.
+	using Deleter = std::function<void(const Byte*)>;
+
+	///@brief Takes ownership of @p data with rows packed without padding.
+	Image(std::unique_ptr<const Byte[]> data, Size width, Size height, PixelFormat format)
+		: Image(
+			data.get(), [](const Byte* data) { delete[] data; },
+			width, height, width * bytesPerPixelOf(format), format
+		)
+	{
+		data.release();
+	}
+	///@brief Adopts @p data with rows @p stride bytes apart without copying it,
+	/// empty @p deleter leaves @p data owned by caller, which must keep it alive while image exists.
+	Image(const Byte* data, Deleter deleter, Size width, Size height, Size stride, PixelFormat format)
+		: m_data(data), m_deleter(std::move(deleter)), m_width(width), m_height(height), m_stride(stride),
+		m_bytesPerPixel(bytesPerPixelOf(format)), m_format(std::move(format))
 	{
 		assert(m_data);
 		assert(width > 0);
 		assert(height > 0);
+		assert(stride >= width * m_bytesPerPixel);
 	}
 	Image(Image&&) noexcept = delete;
 
+	~Image()
+	{
+		if(m_deleter) {
+			m_deleter(m_data);
+		}
+	}
+
 	Size width() const override {
 		return m_width;
 	}
@@ -160,14 +202,23 @@ public:
 		return m_format;
 	}
 	const Byte* data() const override {
-		return m_data.get();
+		return m_data;
+	}
+	Size stride() const override {
+		return m_stride;
+	}
+	Size bytesPerPixel() const override {
+		return m_bytesPerPixel;
 	}
 
 private:
-	PixelFormat m_format;
-	std::unique_ptr<const Byte> m_data;
+	const Byte* m_data;
+	Deleter m_deleter;
 	Size m_width;
 	Size m_height;
+	Size m_stride;
+	Size m_bytesPerPixel;
+	PixelFormat m_format;
 };
 
 class IThumbnailGenerator : public TypesHolder
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "VSNamespace.h"
+#include "VSUtils.h"
+
+namespace tc::file_as_img
+{
+
+enum class Stage
+{
+	///@brief Parsing of document, or its checkout from document cache.
+	Load,
+	///@brief Rasterization of page by library.
+	Render,
+	///@brief Compositing over background and conversion to requested pixel format.
+	Convert,
+	Encode,
+	///@brief Writing of encoded image to file.
+	Write
+};
+
+inline const char* nameOf(Stage stage)
+{
+	switch(stage)
+	{
+	case Stage::Load: return "load";
+	case Stage::Render: return "render";
+	case Stage::Convert: return "convert";
+	case Stage::Encode: return "encode";
+	case Stage::Write: return "write";
+	}
+	return "unknown";
+}
+
+struct StageEvent
+{
+	using Clock = std::chrono::steady_clock;
+	using Path = tc::stdfs::path;
+
+	Stage stage;
+	const Path& file;
+	///@brief Page of document, -1 for stages of whole document.
+	int page;
+	Clock::time_point start;
+	Clock::time_point end;
+	///@brief Thread which has run the stage.
+	std::thread::id thread;
+	///@brief Pixels rendered or converted by the stage.
+	std::uint64_t pixels;
+	///@brief Bytes produced by encode and write stages.
+	std::uint64_t bytes;
+};
+
+///@brief Receives stages of exports from backends, is set by ExportOptions::observer.
+/// Stages of one export run on several threads when it is pipelined, so observer must be thread safe.
+/// With pdf worker processes render stage of page covers waiting for the page rendered by worker, except for its
+/// convert stage, which is measured by worker and reported when the page is received.
+class IExportObserver
+{
+	INTERFACE(IExportObserver)
+public:
+	///@brief Called on thread which has run the stage after it has completed successfully.
+	virtual void onStage(const StageEvent& event) = 0;
+};
+
+///@brief Passes every stage to each of observers in order.
+class ObserverList : public IExportObserver
+{
+public:
+	explicit ObserverList(std::vector<std::shared_ptr<IExportObserver>> observers) :
+		m_observers(std::move(observers))
+	{}
+
+	void onStage(const StageEvent& event) override
+	{
+		for(const auto& observer : m_observers) {
+			observer->onStage(event);
+		}
+	}
+
+private:
+	std::vector<std::shared_ptr<IExportObserver>> m_observers;
+};
+
+///@brief Measures one stage from construction until finish() and reports it to observer,
+/// does nothing if observer is nullptr. Stage is not reported unless finish() is called.
+class StageTimer
+{
+public:
+	StageTimer(IExportObserver* observer, Stage stage, const tc::stdfs::path& file, int page = -1) :
+		m_observer(observer), m_stage(stage), m_file(file), m_page(page)
+	{
+		if(m_observer) {
+			m_start = StageEvent::Clock::now();
+		}
+	}
+	StageTimer(const StageTimer&) = delete;
+	StageTimer& operator=(const StageTimer&) = delete;
+
+	void finish(std::uint64_t pixels = 0, std::uint64_t bytes = 0)
+	{
+		if(!m_observer) {
+			return;
+		}
+		m_observer->onStage(
+			{m_stage, m_file, m_page, m_start, StageEvent::Clock::now(), std::this_thread::get_id(), pixels, bytes}
+		);
+		m_observer = nullptr;
+	}
+	///@brief Reports stage as completed @p tail before now, or at its start if it is shorter than @p tail,
+	/// so the tail measured elsewhere can be reported as the following stage.
+	///@return moment the stage is reported to be completed at.
+	StageEvent::Clock::time_point finishBefore(
+		StageEvent::Clock::duration tail, std::uint64_t pixels = 0, std::uint64_t bytes = 0
+	)
+	{
+		StageEvent::Clock::time_point end = StageEvent::Clock::now();
+		if(!m_observer) {
+			return end;
+		}
+		end = std::max(m_start, end - tail);
+		m_observer->onStage({m_stage, m_file, m_page, m_start, end, std::this_thread::get_id(), pixels, bytes});
+		m_observer = nullptr;
+		return end;
+	}
+
+private:
+	IExportObserver* m_observer;
+	Stage m_stage;
+	const tc::stdfs::path& m_file;
+	int m_page;
+	StageEvent::Clock::time_point m_start;
+};
+
+} //namespace tc::file_as_img
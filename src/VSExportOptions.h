@@ -0,0 +1,390 @@
+#pragma once
+
+#include <algorithm>
+#include <any>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/algorithm/string/split.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "VSCancellationToken.h"
+#include "VSExportObserver.h"
+#include "VSUtils.h"
+
+namespace tc::file_as_img
+{
+
+///@brief Set of zero based page indices to export, empty set selects all pages.
+class PageSet
+{
+public:
+	PageSet() = default;
+
+	///@brief Adds pages [first, first + count).
+	PageSet& add(std::size_t first, std::size_t count = 1)
+	{
+		if(count > 0) {
+			m_ranges.emplace_back(first, first + count);
+		}
+		return *this;
+	}
+
+	bool selectsAll() const {
+		return m_ranges.empty();
+	}
+
+	///@return selected indices of existing pages in ascending order without duplicates.
+	std::vector<int> resolve(int pageCount) const
+	{
+		std::vector<int> pages;
+		if(selectsAll())
+		{
+			for(int i = 0; i < pageCount; ++i) {
+				pages.push_back(i);
+			}
+			return pages;
+		}
+		for(const auto& [first, last] : m_ranges)
+		{
+			for(std::size_t i = first; i < std::min(last, static_cast<std::size_t>(std::max(pageCount, 0))); ++i) {
+				pages.push_back(static_cast<int>(i));
+			}
+		}
+		std::sort(pages.begin(), pages.end());
+		pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+		return pages;
+	}
+
+	///@return index of @p n-th selected page if document had unlimited number of pages.
+	std::size_t nth(std::size_t n) const
+	{
+		if(selectsAll()) {
+			return n;
+		}
+		auto ranges = m_ranges;
+		std::sort(ranges.begin(), ranges.end());
+		std::size_t covered = 0;
+		for(const auto& [first, last] : ranges)
+		{
+			std::size_t begin = std::max(first, covered);
+			if(begin < last)
+			{
+				if(n < last - begin) {
+					return begin + n;
+				}
+				n -= last - begin;
+				covered = last;
+			}
+		}
+		return std::numeric_limits<std::size_t>::max();
+	}
+
+	///@brief Parses comma separated pages and inclusive ranges of pages, e.g. "0,3,40-59".
+	///@throw tc::err::exc::InvalidArgument.
+	static PageSet parse(const std::string& pages)
+	{
+		PageSet result;
+		std::vector<std::string> items;
+		boost::algorithm::split(items, pages, [](char c) { return c == ','; });
+		try
+		{
+			for(const std::string& item : items)
+			{
+				std::size_t dash = item.find('-');
+				std::size_t first = boost::lexical_cast<std::size_t>(item.substr(0, dash));
+				std::size_t last = dash == std::string::npos ? first : boost::lexical_cast<std::size_t>(item.substr(dash + 1));
+				if(last < first) {
+					throw tc::err::exc::InvalidArgument("Invalid range of pages " + item);
+				}
+				result.add(first, last - first + 1);
+			}
+		}
+		catch(const boost::bad_lexical_cast&)
+		{
+			throw tc::err::exc::InvalidArgument("Invalid pages " + pages);
+		}
+		return result;
+	}
+
+private:
+	std::vector<std::pair<std::size_t, std::size_t>> m_ranges;
+};
+
+///@brief Box images are fitted in keeping aspect ratio of pages, empty box does not constrain images.
+struct BoundingBox
+{
+	std::size_t width = 0;
+	std::size_t height = 0;
+
+	bool empty() const {
+		return width == 0 || height == 0;
+	}
+
+	///@brief Parses <width>x<height>, e.g. "256x256".
+	///@throw tc::err::exc::InvalidArgument.
+	static BoundingBox parse(const std::string& box)
+	{
+		std::size_t x = box.find('x');
+		try
+		{
+			if(x != std::string::npos)
+			{
+				BoundingBox result{
+					boost::lexical_cast<std::size_t>(box.substr(0, x)), boost::lexical_cast<std::size_t>(box.substr(x + 1))
+				};
+				if(!result.empty()) {
+					return result;
+				}
+			}
+		}
+		catch(const boost::bad_lexical_cast&)
+		{}
+		throw tc::err::exc::InvalidArgument("Invalid bounding box " + box);
+	}
+};
+
+///@brief Quality settings of rendering, defaults are full quality rendering of backends.
+struct RenderOptions
+{
+	bool antialiasing = true;
+	///@brief Fitting of glyphs to pixel grid, ignored by pdf backend.
+	bool textHinting = true;
+	///@brief Colour 0xRRGGBB of background transparent areas of pages are composited over.
+	std::uint32_t background = 0xFFFFFF;
+
+	///@brief Fastest legible rendering for bulk jobs, text and lines are jagged.
+	static RenderOptions draft()
+	{
+		RenderOptions options;
+		options.antialiasing = false;
+		options.textHinting = false;
+		return options;
+	}
+
+	bool isDefault() const {
+		return antialiasing && textHinting && background == RenderOptions().background;
+	}
+
+	///@brief Parses colour in hexadecimal RRGGBB notation, e.g. "ffffff".
+	///@throw tc::err::exc::InvalidArgument.
+	static std::uint32_t parseColor(const std::string& color)
+	{
+		std::size_t parsed = 0;
+		unsigned long value = 0;
+		try {
+			value = std::stoul(color, &parsed, 16);
+		}
+		catch(const std::exception&)
+		{}
+		if(color.size() != 6 || parsed != color.size() || value > 0xFFFFFF) {
+			throw tc::err::exc::InvalidArgument("Invalid colour " + color);
+		}
+		return static_cast<std::uint32_t>(value);
+	}
+};
+
+///@brief Settings of taking thumbnails of presentation packages from their embedded preview images.
+struct EmbeddedThumbnailOptions
+{
+	///@brief Enables preview images, which are taken without loading presentation when they are present.
+	bool enabled = false;
+	///@brief Smaller previews are not taken and thumbnail is rendered.
+	BoundingBox minSize;
+};
+
+///@brief Time budgets of export, zero budget is unlimited. Exceeding budget fails export with tc::err::exc::Timeout.
+struct TimeoutOptions
+{
+	///@brief Budget of whole document from start of its export.
+	std::chrono::milliseconds document{0};
+	///@brief Budget of rendering of every page. Pdf pages are rendered by worker processes when it is set and
+	/// VSQtPdfManager has worker executable, slides by abandonable threads, so page exceeding it is abandoned as soon
+	/// as it expires, other pages are checked once they are rendered.
+	std::chrono::milliseconds page{0};
+	///@brief Page exceeding its budget is exported as placeholder of its size filled with background colour
+	/// instead of failing export, exceeded budget of document still fails it.
+	bool placeholder = false;
+
+	bool isUnlimited() const {
+		return document.count() <= 0 && page.count() <= 0;
+	}
+};
+
+///@brief Settings of PNG encoder trading output size for encoding speed, defaults match zlib defaults.
+struct PngOptions
+{
+	///@brief Row filter applied before deflate, Adaptive chooses best filter for every row.
+	enum class Filter { None, Sub, Up, Average, Paeth, Adaptive };
+	///@brief Deflate strategy, Rle and HuffmanOnly are fastest but lose on text and line art of rendered pages.
+	enum class Strategy { Default, Filtered, HuffmanOnly, Rle, Fixed };
+
+	///@brief zlib compression level from 0 (store) to 9 (smallest).
+	int compressionLevel = 6;
+	Filter filter = Filter::Adaptive;
+	Strategy strategy = Strategy::Default;
+
+	///@brief Preset encoding rendered pages about three times faster than defaults for about 20% larger files.
+	static PngOptions fast()
+	{
+		PngOptions options;
+		options.compressionLevel = 1;
+		options.filter = Filter::Up;
+		return options;
+	}
+
+	///@brief Parses none, sub, up, average, paeth or adaptive.
+	///@throw tc::err::exc::InvalidArgument.
+	static Filter parseFilter(const std::string& filter)
+	{
+		static const std::pair<const char*, Filter> names[] = {
+			{"none", Filter::None}, {"sub", Filter::Sub}, {"up", Filter::Up},
+			{"average", Filter::Average}, {"paeth", Filter::Paeth}, {"adaptive", Filter::Adaptive}
+		};
+		for(const auto& [name, value] : names)
+		{
+			if(filter == name) {
+				return value;
+			}
+		}
+		throw tc::err::exc::InvalidArgument("Invalid png filter " + filter);
+	}
+
+	///@brief Parses default, filtered, huffman, rle or fixed.
+	///@throw tc::err::exc::InvalidArgument.
+	static Strategy parseStrategy(const std::string& strategy)
+	{
+		static const std::pair<const char*, Strategy> names[] = {
+			{"default", Strategy::Default}, {"filtered", Strategy::Filtered}, {"huffman", Strategy::HuffmanOnly},
+			{"rle", Strategy::Rle}, {"fixed", Strategy::Fixed}
+		};
+		for(const auto& [name, value] : names)
+		{
+			if(strategy == name) {
+				return value;
+			}
+		}
+		throw tc::err::exc::InvalidArgument("Invalid png strategy " + strategy);
+	}
+};
+
+///@brief Settings of JPEG encoder, defaults match libjpeg defaults.
+struct JpegOptions
+{
+	///@brief Resolution of chroma relative to luma, 420 halves it in both directions.
+	enum class Subsampling { S444, S422, S420 };
+
+	///@brief From 1 (smallest) to 100 (best).
+	int quality = 75;
+	Subsampling subsampling = Subsampling::S420;
+	///@brief Progressive files are smaller and displayed incrementally but take longer to encode.
+	bool progressive = false;
+
+	///@brief Parses 444, 422 or 420.
+	///@throw tc::err::exc::InvalidArgument.
+	static Subsampling parseSubsampling(const std::string& subsampling)
+	{
+		if(subsampling == "444") {
+			return Subsampling::S444;
+		}
+		if(subsampling == "422") {
+			return Subsampling::S422;
+		}
+		if(subsampling == "420") {
+			return Subsampling::S420;
+		}
+		throw tc::err::exc::InvalidArgument("Invalid jpeg subsampling " + subsampling);
+	}
+};
+
+///@brief Settings of WebP encoder.
+struct WebpOptions
+{
+	bool lossless = false;
+	///@brief From 0 to 100, image quality of lossy and compression effort of lossless encoding.
+	float quality = 75.0f;
+	///@brief From 0 (fastest) to 6 (smallest).
+	int method = 4;
+};
+
+///@brief Typed options understood by exporters and thumbnail generators of this library.
+/// Bare DPI value is still accepted in place of them, other fields have their default values then.
+struct ExportOptions
+{
+	using DPI = double;
+
+	DPI dpi = 96.0;
+	///@brief Number of workers rendering pages concurrently, values less than 2 mean sequential rendering.
+	/// Produced images are delivered in page order regardless of this value.
+	std::size_t workers = 1;
+	///@brief Capacity of the queues between render, encode and write stages of fs exporters,
+	/// 0 means images are encoded and written by the rendering thread.
+	std::size_t pipelineDepth = 2;
+	///@brief Pdf pages exported to png or jpeg files are rendered and encoded in bands of this many rows,
+	/// so memory is bounded by band rather than page area, 0 renders whole pages.
+	std::size_t bandHeight = 0;
+	RenderOptions render;
+	///@brief Pages are rendered directly at the largest size fitting in this box instead of at dpi unless it is empty.
+	BoundingBox fitWithin;
+	///@brief Used by thumbnail generators of presentations.
+	EmbeddedThumbnailOptions embeddedThumbnail;
+	///@brief Pages to export, only these pages are rendered. Thumbnail is generated from the first of them.
+	PageSet pages;
+	///@brief Used by exporters producing "png" images.
+	PngOptions png;
+	///@brief Used by exporters producing "jpg" and "jpeg" images.
+	JpegOptions jpeg;
+	///@brief Used by exporters producing "webp" images.
+	WebpOptions webp;
+	///@brief Receives stages of export unless it is nullptr.
+	std::shared_ptr<IExportObserver> observer;
+	///@brief Cancels export in addition to interrupt of backend, budgets of timeouts are counted within its deadline.
+	CancellationToken cancellation;
+	TimeoutOptions timeouts;
+};
+
+///@return width and height in pixels of image rendered from page of @p pointWidth x @p pointHeight points.
+inline std::pair<int, int> pixelSizeOf(const ExportOptions& options, double pointWidth, double pointHeight)
+{
+	if(options.fitWithin.empty() || pointWidth <= 0 || pointHeight <= 0)
+	{
+		return {
+			static_cast<int>(tc::pointsToPixels(pointWidth, options.dpi)),
+			static_cast<int>(tc::pointsToPixels(pointHeight, options.dpi))
+		};
+	}
+	double boxWidth = static_cast<double>(options.fitWithin.width);
+	double boxHeight = static_cast<double>(options.fitWithin.height);
+	double scale = std::min(boxWidth / pointWidth, boxHeight / pointHeight);
+	return {
+		static_cast<int>(std::clamp(std::round(pointWidth * scale), 1.0, boxWidth)),
+		static_cast<int>(std::clamp(std::round(pointHeight * scale), 1.0, boxHeight))
+	};
+}
+
+inline bool holdsExportOptions(const std::any& options)
+{
+	return !options.has_value() ||
+		std::any_cast<ExportOptions::DPI>(&options) != nullptr ||
+		std::any_cast<ExportOptions>(&options) != nullptr;
+}
+
+///@pre holdsExportOptions(options).
+inline ExportOptions exportOptionsFrom(const std::any& options)
+{
+	if(const auto* dpi = std::any_cast<ExportOptions::DPI>(&options)) {
+		ExportOptions result;
+		result.dpi = *dpi;
+		return result;
+	}
+	return options.has_value() ? std::any_cast<ExportOptions>(options) : ExportOptions();
+}
+
+} //namespace tc::file_as_img
\ No newline at end of file
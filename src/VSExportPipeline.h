@@ -0,0 +1,190 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "VSExportFileAsImages.h"
+#include "VSBoundedQueue.h"
+
+namespace tc::file_as_img::fs
+{
+
+///@brief Writes new file at @p path, existing file is unlinked rather than truncated,
+/// so its hard links, e.g. in RenderCache, are kept intact.
+inline void writeImageFile(const TypesHolder::Path& path, const char* data, std::size_t size)
+{
+	std::error_code err;
+	tc::stdfs::remove(path, err);
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(data, static_cast<std::streamsize>(size));
+	file.close();
+	if(!file) {
+		throw std::runtime_error("Unable to write image file " + path.string());
+	}
+}
+
+///@brief Encodes and writes rendered images in two threads connected by bounded queues, so encoding of one page
+/// overlaps with rendering of the next one while at most 2 * depth + 2 images are held by the pipeline.
+/// Images are written and their names are reported in push order, names are reported on the pushing thread.
+template<typename Rendered, typename Encoded>
+class ExportPipeline
+{
+public:
+	using String = TypesHolder::String;
+	using Encoder = std::function<Encoded(Rendered&)>;
+	using Writer = std::function<void(const Encoded&, const String&)>;
+	using NameConsumer = std::function<void(const String&)>;
+
+	ExportPipeline(std::size_t depth, Encoder encode, Writer write, NameConsumer forEachImageName) :
+		m_encode(std::move(encode)), m_write(std::move(write)), m_forEachImageName(std::move(forEachImageName)),
+		m_toEncode(depth), m_toWrite(depth), m_written(std::numeric_limits<std::size_t>::max())
+	{
+		assert(depth > 0);
+		m_encoder = std::thread(&ExportPipeline::runEncoder, this);
+		m_writer = std::thread(&ExportPipeline::runWriter, this);
+	}
+	ExportPipeline(const ExportPipeline&) = delete;
+	ExportPipeline& operator=(const ExportPipeline&) = delete;
+
+	~ExportPipeline()
+	{
+		m_stopped = true;
+		m_toEncode.close();
+		m_toWrite.close();
+		join();
+	}
+
+	///@brief Passes @p rendered to encode stage, blocks while encode queue is full.
+	/// Reports names of images written so far.
+	///@throw exception thrown by encode or write stage.
+	void push(Rendered rendered, String imageName)
+	{
+		reportWritten();
+		if(!m_toEncode.push({std::move(rendered), std::move(imageName)})) {
+			rethrowError();
+			throw std::logic_error("Push to finished export pipeline");
+		}
+	}
+
+	///@brief Waits until all pushed images are written and reports their names.
+	///@throw exception thrown by encode or write stage.
+	void finish()
+	{
+		m_toEncode.close();
+		join();
+		rethrowError();
+		reportWritten();
+	}
+
+private:
+	struct ToEncode
+	{
+		Rendered rendered;
+		String imageName;
+	};
+
+	struct ToWrite
+	{
+		Encoded encoded;
+		String imageName;
+	};
+
+	void runEncoder()
+	{
+		try
+		{
+			while(std::optional<ToEncode> item = m_toEncode.pop())
+			{
+				if(m_stopped || !m_toWrite.push({m_encode(item->rendered), std::move(item->imageName)})) {
+					break;
+				}
+			}
+		}
+		catch(...)
+		{
+			setError(std::current_exception());
+		}
+		m_toWrite.close();
+	}
+
+	void runWriter()
+	{
+		try
+		{
+			while(std::optional<ToWrite> item = m_toWrite.pop())
+			{
+				if(m_stopped) {
+					break;
+				}
+				m_write(item->encoded, item->imageName);
+				m_written.push(std::move(item->imageName));
+			}
+		}
+		catch(...)
+		{
+			setError(std::current_exception());
+		}
+	}
+
+	void setError(std::exception_ptr error)
+	{
+		{
+			std::lock_guard lock(m_errorMutex);
+			if(!m_error) {
+				m_error = error;
+			}
+		}
+		m_stopped = true;
+		m_toEncode.close();
+		m_toWrite.close();
+	}
+
+	void rethrowError()
+	{
+		std::lock_guard lock(m_errorMutex);
+		if(m_error) {
+			std::rethrow_exception(m_error);
+		}
+	}
+
+	void join()
+	{
+		if(m_encoder.joinable()) {
+			m_encoder.join();
+		}
+		if(m_writer.joinable()) {
+			m_writer.join();
+		}
+	}
+
+	void reportWritten()
+	{
+		String imageName;
+		while(m_written.popFor(imageName, std::chrono::seconds(0)) == BoundedQueue<String>::Status::Ok) {
+			m_forEachImageName(imageName);
+		}
+	}
+
+	Encoder m_encode;
+	Writer m_write;
+	NameConsumer m_forEachImageName;
+	BoundedQueue<ToEncode> m_toEncode;
+	BoundedQueue<ToWrite> m_toWrite;
+	BoundedQueue<String> m_written;
+	std::mutex m_errorMutex;
+	std::exception_ptr m_error;
+	std::atomic_bool m_stopped = false;
+	std::thread m_encoder;
+	std::thread m_writer;
+};
+
+} //namespace tc::file_as_img::fs
\ No newline at end of file
@@ -0,0 +1,55 @@
+#include "VSFrameWriter.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <unistd.h>
+
+namespace
+{
+
+void writeAll(int fd, const void* data, std::size_t size)
+{
+	auto* bytes = static_cast<const char*>(data);
+	while(size > 0)
+	{
+		ssize_t written = ::write(fd, bytes, size);
+		if(written < 0 && errno == EINTR) {
+			continue;
+		}
+		if(written <= 0) {
+			throw std::runtime_error(std::string("Unable to write frame: ") + std::strerror(errno));
+		}
+		bytes += written;
+		size -= static_cast<std::size_t>(written);
+	}
+}
+
+void appendBigEndian(std::string& header, std::uint64_t value, int byteCount)
+{
+	for(int i = byteCount - 1; i >= 0; --i) {
+		header.push_back(static_cast<char>(value >> (8 * i)));
+	}
+}
+
+}
+
+VSFrameWriter::VSFrameWriter(int fd) :
+	m_fd(fd)
+{}
+
+void VSFrameWriter::write(std::uint32_t index, const std::string& imageFormat, const std::uint8_t* data, std::size_t size)
+{
+	if(imageFormat.size() > 0xFF) {
+		throw std::invalid_argument("Too long image format " + imageFormat);
+	}
+	std::string header;
+	appendBigEndian(header, index, 4);
+	appendBigEndian(header, imageFormat.size(), 1);
+	header += imageFormat;
+	appendBigEndian(header, size, 8);
+	std::lock_guard lock(m_mutex);
+	writeAll(m_fd, header.data(), header.size());
+	writeAll(m_fd, data, size);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+///@brief Writes encoded images to file descriptor as frames, so they are piped to consumer without temporary files.
+///
+/// Every frame is 4-byte big-endian image index, 1-byte length of image format, image format,
+/// 8-byte big-endian payload length and payload of encoded image. Stream ends with end of file.
+/// Indices are the same as numbers of image names of file export, i.e. 0, 1, ... in export order.
+/// Frames are written whole, so writer can be shared by several threads.
+class VSFrameWriter
+{
+public:
+	///@brief Writes to @p fd, which is left open.
+	explicit VSFrameWriter(int fd);
+	VSFrameWriter(const VSFrameWriter&) = delete;
+	VSFrameWriter& operator=(const VSFrameWriter&) = delete;
+
+	///@throw std::runtime_error if frame can not be written.
+	void write(std::uint32_t index, const std::string& imageFormat, const std::uint8_t* data, std::size_t size);
+
+private:
+	int m_fd;
+	std::mutex m_mutex;
+};
@@ -0,0 +1,149 @@
+#include "VSImageDecoder.h"
+
+#include <cassert>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <jpeglib.h>
+#include <png.h>
+
+namespace tc::file_as_img::dec
+{
+
+namespace
+{
+
+using Byte = mem::IImage::Byte;
+
+bool isLittleEndian()
+{
+	const std::uint32_t one = 1;
+	std::uint8_t firstByte;
+	std::memcpy(&firstByte, &one, 1);
+	return firstByte == 1;
+}
+
+std::unique_ptr<mem::Image> decodePng(const std::uint8_t* data, std::size_t size, const mem::IImage::PixelFormat& pixelFormat)
+{
+	png_image image{};
+	image.version = PNG_IMAGE_VERSION;
+	if(!png_image_begin_read_from_memory(&image, data, size)) {
+		throw std::runtime_error(std::string("Png decoding error: ") + image.message);
+	}
+	//argb32 words are B, G, R, A bytes on little endian and A, R, G, B bytes on big endian machines.
+	if(pixelFormat == "argb32") {
+		image.format = isLittleEndian() ? PNG_FORMAT_BGRA : PNG_FORMAT_ARGB;
+	}
+	else if(pixelFormat == "rgba8888") {
+		image.format = PNG_FORMAT_RGBA;
+	}
+	else if(pixelFormat == "rgb888") {
+		image.format = PNG_FORMAT_RGB;
+	}
+	else
+	{
+		png_image_free(&image);
+		throw tc::err::exc::InvalidArgument("Invalid pixel format");
+	}
+	std::size_t width = image.width;
+	std::size_t height = image.height;
+	std::size_t stride = PNG_IMAGE_ROW_STRIDE(image);
+	std::unique_ptr<Byte[]> pixels(new Byte[stride * height]);
+	const png_color white{255, 255, 255};
+	if(!png_image_finish_read(&image, &white, pixels.get(), static_cast<png_int_32>(stride), nullptr)) {
+		throw std::runtime_error(std::string("Png decoding error: ") + image.message);
+	}
+	return std::make_unique<mem::Image>(std::unique_ptr<const Byte[]>(pixels.release()), width, height, pixelFormat);
+}
+
+//libjpeg reports errors by error_exit, which must not return, so it jumps back to decodeJpeg.
+//Pixels are held here rather than in local variable, which would be indeterminate after jump.
+struct JpegContext
+{
+	jpeg_error_mgr errorManager;
+	std::jmp_buf jump;
+	std::string error;
+	std::unique_ptr<Byte[]> pixels;
+
+	static void onErrorExit(j_common_ptr cinfo)
+	{
+		auto* self = reinterpret_cast<JpegContext*>(cinfo->err);
+		char message[JMSG_LENGTH_MAX];
+		(*cinfo->err->format_message)(cinfo, message);
+		self->error = message;
+		std::longjmp(self->jump, 1);
+	}
+
+	static void onOutputMessage(j_common_ptr)
+	{}
+};
+
+std::unique_ptr<mem::Image> decodeJpeg(
+	const std::uint8_t* data, std::size_t size, const mem::IImage::PixelFormat& pixelFormat
+)
+{
+	J_COLOR_SPACE colorSpace = JCS_RGB;
+#ifdef JCS_EXTENSIONS
+	if(pixelFormat == "argb32") {
+		colorSpace = isLittleEndian() ? JCS_EXT_BGRA : JCS_EXT_ARGB;
+	}
+	else if(pixelFormat == "rgba8888") {
+		colorSpace = JCS_EXT_RGBA;
+	}
+#endif
+	if(colorSpace == JCS_RGB && pixelFormat != "rgb888") {
+		throw tc::err::exc::InvalidArgument("Pixel format is not supported by jpeg decoder");
+	}
+	std::size_t bytesPerPixel = mem::bytesPerPixelOf(pixelFormat);
+
+	JpegContext context;
+	jpeg_decompress_struct cinfo{};
+	cinfo.err = jpeg_std_error(&context.errorManager);
+	context.errorManager.error_exit = &JpegContext::onErrorExit;
+	context.errorManager.output_message = &JpegContext::onOutputMessage;
+	if(setjmp(context.jump))
+	{
+		jpeg_destroy_decompress(&cinfo);
+		throw std::runtime_error("Jpeg decoding error: " + context.error);
+	}
+	jpeg_create_decompress(&cinfo);
+	jpeg_mem_src(&cinfo, data, static_cast<unsigned long>(size));
+	jpeg_read_header(&cinfo, TRUE);
+	cinfo.out_color_space = colorSpace;
+	jpeg_start_decompress(&cinfo);
+	std::size_t width = cinfo.output_width;
+	std::size_t height = cinfo.output_height;
+	std::size_t stride = width * bytesPerPixel;
+	context.pixels.reset(new Byte[stride * height]);
+	while(cinfo.output_scanline < cinfo.output_height)
+	{
+		JSAMPROW rows[] = {reinterpret_cast<JSAMPROW>(context.pixels.get() + cinfo.output_scanline * stride)};
+		jpeg_read_scanlines(&cinfo, rows, 1);
+	}
+	jpeg_finish_decompress(&cinfo);
+	jpeg_destroy_decompress(&cinfo);
+	return std::make_unique<mem::Image>(std::unique_ptr<const Byte[]>(context.pixels.release()), width, height, pixelFormat);
+}
+
+}
+
+bool isDecoded(const std::string& imageFormat)
+{
+	return imageFormat == "png" || imageFormat == "jpg" || imageFormat == "jpeg";
+}
+
+std::unique_ptr<mem::Image> decode(
+	const std::uint8_t* data, std::size_t size, const std::string& imageFormat, const mem::IImage::PixelFormat& pixelFormat
+)
+{
+	assert(isDecoded(imageFormat));
+	if(imageFormat == "png") {
+		return decodePng(data, size, pixelFormat);
+	}
+	return decodeJpeg(data, size, pixelFormat);
+}
+
+} //namespace tc::file_as_img::dec
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "VSExportFileAsImages.h"
+
+namespace tc::file_as_img::dec
+{
+
+///@return true if images of @p imageFormat are decoded by decode(): png, jpg and jpeg.
+bool isDecoded(const std::string& imageFormat);
+
+///@brief Decodes image directly to @p pixelFormat, which is one of pixel formats defined by mem::IImage.
+/// Transparent png images lose alpha channel over white background when decoded to rgb888.
+///@pre isDecoded(imageFormat).
+///@throw tc::err::exc::InvalidArgument if @p pixelFormat is not defined or not supported by decoder.
+///@throw std::runtime_error if image is corrupted.
+std::unique_ptr<mem::Image> decode(
+	const std::uint8_t* data, std::size_t size, const std::string& imageFormat, const mem::IImage::PixelFormat& pixelFormat
+);
+
+} //namespace tc::file_as_img::dec
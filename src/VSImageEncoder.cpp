@@ -0,0 +1,52 @@
+#include "VSImageEncoder.h"
+
+#include <cassert>
+#include <utility>
+
+#include "VSJpegEncoder.h"
+#include "VSPngEncoder.h"
+#include "VSWebpEncoder.h"
+
+namespace tc::file_as_img::enc
+{
+
+bool isEncoded(const std::string& imageFormat)
+{
+	return imageFormat == "png" || imageFormat == "jpg" || imageFormat == "jpeg" || imageFormat == "webp";
+}
+
+void encode(
+	const std::uint8_t* pixels, std::size_t width, std::size_t height, std::ptrdiff_t stride, bool alpha,
+	const std::string& imageFormat, const ExportOptions& options, const Sink& sink
+)
+{
+	assert(isEncoded(imageFormat));
+	if(imageFormat == "png") {
+		encodePng(pixels, width, height, stride, alpha, options.png, sink);
+	}
+	else if(imageFormat == "webp") {
+		encodeWebp(pixels, width, height, stride, options.webp, sink);
+	}
+	else {
+		encodeJpeg(pixels, width, height, stride, options.jpeg, sink);
+	}
+}
+
+bool isRowEncoded(const std::string& imageFormat)
+{
+	return imageFormat == "png" || imageFormat == "jpg" || imageFormat == "jpeg";
+}
+
+std::unique_ptr<RowEncoder> makeRowEncoder(
+	std::size_t width, std::size_t height, bool alpha,
+	const std::string& imageFormat, const ExportOptions& options, Sink sink
+)
+{
+	assert(isRowEncoded(imageFormat));
+	if(imageFormat == "png") {
+		return std::make_unique<PngEncoder>(width, height, alpha, options.png, std::move(sink));
+	}
+	return std::make_unique<JpegEncoder>(width, height, options.jpeg, std::move(sink));
+}
+
+} //namespace tc::file_as_img::enc
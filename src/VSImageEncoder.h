@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "VSExportOptions.h"
+
+namespace tc::file_as_img::enc
+{
+
+///@brief Receives encoded bytes as soon as encoder produces them.
+using Sink = std::function<void(const std::uint8_t* data, std::size_t size)>;
+
+///@brief Encoder consuming image of argb32 rows band by band, so image need not be complete in memory.
+class RowEncoder
+{
+public:
+	virtual ~RowEncoder() = default;
+
+	///@brief Writes @p count rows of width() argb32 pixels, row i starts at @p rows + i * @p stride bytes.
+	///@throw std::runtime_error on encoding error, exception thrown by sink is rethrown as is.
+	/// Encoder can not be used after exception.
+	virtual void writeRows(const std::uint8_t* rows, std::size_t count, std::ptrdiff_t stride) = 0;
+	///@brief Completes image.
+	///@pre all height() rows have been written.
+	virtual void finish() = 0;
+
+	virtual std::size_t width() const = 0;
+	virtual std::size_t height() const = 0;
+	virtual std::size_t rowsWritten() const = 0;
+};
+
+///@return true if images of @p imageFormat are encoded by encoders of this library: png, jpg, jpeg and webp.
+bool isEncoded(const std::string& imageFormat);
+
+///@brief Encodes image of argb32 rows to @p imageFormat with settings of @p options,
+/// row i starts at @p pixels + i * @p stride bytes.
+///@param alpha false ignores alpha channel of pixels.
+///@pre isEncoded(imageFormat), @p stride is multiple of 4.
+///@throw exceptions of encoder of @p imageFormat.
+void encode(
+	const std::uint8_t* pixels, std::size_t width, std::size_t height, std::ptrdiff_t stride, bool alpha,
+	const std::string& imageFormat, const ExportOptions& options, const Sink& sink
+);
+
+///@return true if images of @p imageFormat are encoded row by row: png, jpg and jpeg.
+bool isRowEncoded(const std::string& imageFormat);
+
+///@brief Creates row encoder of @p imageFormat with settings of @p options.
+///@param alpha false ignores alpha channel of pixels.
+///@pre isRowEncoded(imageFormat).
+///@throw exceptions of encoder of @p imageFormat.
+std::unique_ptr<RowEncoder> makeRowEncoder(
+	std::size_t width, std::size_t height, bool alpha,
+	const std::string& imageFormat, const ExportOptions& options, Sink sink
+);
+
+} //namespace tc::file_as_img::enc
@@ -0,0 +1,251 @@
+#include "VSJpegEncoder.h"
+
+#include <cassert>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <jpeglib.h>
+
+#include "VSPixelKernels.h"
+
+namespace tc::file_as_img::enc
+{
+
+namespace
+{
+
+constexpr std::size_t outputBufferSize = 64 * 1024;
+
+J_COLOR_SPACE inputColorSpace()
+{
+#ifdef JCS_EXTENSIONS
+	const std::uint32_t one = 1;
+	std::uint8_t firstByte;
+	std::memcpy(&firstByte, &one, 1);
+	bool isLittleEndian = firstByte == 1;
+	//argb32 words are B, G, R, A bytes on little endian and A, R, G, B bytes on big endian machines.
+	return isLittleEndian ? JCS_EXT_BGRX : JCS_EXT_XRGB;
+#else
+	return JCS_RGB;
+#endif
+}
+
+void setSubsampling(jpeg_compress_struct& cinfo, JpegOptions::Subsampling subsampling)
+{
+	//Chroma components are sampled once per horizontal x vertical block of luma samples.
+	assert(cinfo.num_components == 3);
+	int horizontal = subsampling == JpegOptions::Subsampling::S444 ? 1 : 2;
+	int vertical = subsampling == JpegOptions::Subsampling::S420 ? 2 : 1;
+	cinfo.comp_info[0].h_samp_factor = horizontal;
+	cinfo.comp_info[0].v_samp_factor = vertical;
+	for(int i = 1; i < 3; ++i)
+	{
+		cinfo.comp_info[i].h_samp_factor = 1;
+		cinfo.comp_info[i].v_samp_factor = 1;
+	}
+}
+
+}
+
+//libjpeg reports errors by error_exit, which must not return, so it jumps back to the method of encoder that called
+//libjpeg, no exception is thrown through libjpeg frames.
+struct JpegEncoder::State
+{
+	jpeg_compress_struct cinfo{};
+	jpeg_error_mgr errorManager;
+	jpeg_destination_mgr destinationManager;
+	std::jmp_buf jump;
+	Sink sink;
+	std::vector<JOCTET> buffer;
+	J_COLOR_SPACE colorSpace = JCS_RGB;
+	std::vector<std::uint8_t> rgbRow;
+	bool created = false;
+	bool failed = false;
+	std::string error;
+	std::exception_ptr sinkError;
+
+	~State()
+	{
+		if(created) {
+			jpeg_destroy_compress(&cinfo);
+		}
+	}
+
+	[[noreturn]] void rethrow()
+	{
+		failed = true;
+		if(sinkError) {
+			std::rethrow_exception(sinkError);
+		}
+		throw std::runtime_error("Jpeg encoding error: " + error);
+	}
+
+	static State& of(j_common_ptr cinfo) {
+		return *static_cast<State*>(cinfo->client_data);
+	}
+
+	static void onErrorExit(j_common_ptr cinfo)
+	{
+		State& state = of(cinfo);
+		char message[JMSG_LENGTH_MAX];
+		(*cinfo->err->format_message)(cinfo, message);
+		state.error = message;
+		std::longjmp(state.jump, 1);
+	}
+
+	static void onOutputMessage(j_common_ptr)
+	{}
+
+	static void onInitDestination(j_compress_ptr cinfo)
+	{
+		State& state = of(reinterpret_cast<j_common_ptr>(cinfo));
+		cinfo->dest->next_output_byte = state.buffer.data();
+		cinfo->dest->free_in_buffer = state.buffer.size();
+	}
+
+	static boolean onEmptyOutputBuffer(j_compress_ptr cinfo)
+	{
+		State& state = of(reinterpret_cast<j_common_ptr>(cinfo));
+		state.write(state.buffer.size());
+		cinfo->dest->next_output_byte = state.buffer.data();
+		cinfo->dest->free_in_buffer = state.buffer.size();
+		return TRUE;
+	}
+
+	static void onTermDestination(j_compress_ptr cinfo)
+	{
+		State& state = of(reinterpret_cast<j_common_ptr>(cinfo));
+		state.write(state.buffer.size() - cinfo->dest->free_in_buffer);
+	}
+
+	void write(std::size_t size)
+	{
+		try {
+			sink(buffer.data(), size);
+		}
+		catch(...) {
+			sinkError = std::current_exception();
+		}
+		//Jump must not leave catch block, exception would never be released.
+		if(sinkError) {
+			std::longjmp(jump, 1);
+		}
+	}
+};
+
+JpegEncoder::JpegEncoder(std::size_t width, std::size_t height, const JpegOptions& options, Sink sink) :
+	m_state(std::make_unique<State>())
+{
+	if(width == 0 || height == 0 || width > JPEG_MAX_DIMENSION || height > JPEG_MAX_DIMENSION) {
+		throw tc::err::exc::InvalidArgument("Invalid size of jpeg image");
+	}
+	if(options.quality < 1 || options.quality > 100) {
+		throw tc::err::exc::InvalidArgument("Invalid jpeg quality");
+	}
+	assert(sink);
+
+	State& state = *m_state;
+	state.sink = std::move(sink);
+	state.buffer.resize(outputBufferSize);
+	state.colorSpace = inputColorSpace();
+	state.rgbRow.resize(state.colorSpace == JCS_RGB ? width * 3 : 0);
+	jpeg_compress_struct& cinfo = state.cinfo;
+	cinfo.err = jpeg_std_error(&state.errorManager);
+	cinfo.client_data = &state;
+	state.errorManager.error_exit = &State::onErrorExit;
+	state.errorManager.output_message = &State::onOutputMessage;
+	if(setjmp(state.jump)) {
+		state.rethrow();
+	}
+	jpeg_create_compress(&cinfo);
+	state.created = true;
+	state.destinationManager.init_destination = &State::onInitDestination;
+	state.destinationManager.empty_output_buffer = &State::onEmptyOutputBuffer;
+	state.destinationManager.term_destination = &State::onTermDestination;
+	cinfo.dest = &state.destinationManager;
+
+	cinfo.image_width = static_cast<JDIMENSION>(width);
+	cinfo.image_height = static_cast<JDIMENSION>(height);
+	cinfo.input_components = state.colorSpace == JCS_RGB ? 3 : 4;
+	cinfo.in_color_space = state.colorSpace;
+	jpeg_set_defaults(&cinfo);
+	jpeg_set_quality(&cinfo, options.quality, TRUE);
+	setSubsampling(cinfo, options.subsampling);
+	if(options.progressive) {
+		jpeg_simple_progression(&cinfo);
+	}
+	jpeg_start_compress(&cinfo, TRUE);
+}
+
+JpegEncoder::~JpegEncoder() = default;
+
+void JpegEncoder::writeRows(const std::uint8_t* rows, std::size_t count, std::ptrdiff_t stride)
+{
+	State& state = *m_state;
+	if(state.failed) {
+		throw std::logic_error("Jpeg encoder has failed");
+	}
+	jpeg_compress_struct& cinfo = state.cinfo;
+	assert(cinfo.next_scanline + count <= cinfo.image_height);
+	if(setjmp(state.jump)) {
+		state.rethrow();
+	}
+	const tc::pixel::Kernels& kernels = tc::pixel::kernels();
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		const std::uint8_t* row = rows + static_cast<std::ptrdiff_t>(i) * stride;
+		if(state.colorSpace == JCS_RGB)
+		{
+			kernels.argb32ToRgb888(reinterpret_cast<const std::uint32_t*>(row), state.rgbRow.data(), cinfo.image_width);
+			row = state.rgbRow.data();
+		}
+		JSAMPROW sampleRows[] = {const_cast<JSAMPROW>(row)};
+		jpeg_write_scanlines(&cinfo, sampleRows, 1);
+	}
+}
+
+void JpegEncoder::finish()
+{
+	State& state = *m_state;
+	if(state.failed) {
+		throw std::logic_error("Jpeg encoder has failed");
+	}
+	assert(state.cinfo.next_scanline == state.cinfo.image_height);
+	if(setjmp(state.jump)) {
+		state.rethrow();
+	}
+	jpeg_finish_compress(&state.cinfo);
+}
+
+std::size_t JpegEncoder::width() const
+{
+	return m_state->cinfo.image_width;
+}
+
+std::size_t JpegEncoder::height() const
+{
+	return m_state->cinfo.image_height;
+}
+
+std::size_t JpegEncoder::rowsWritten() const
+{
+	return m_state->cinfo.next_scanline;
+}
+
+void encodeJpeg(
+	const std::uint8_t* pixels, std::size_t width, std::size_t height, std::ptrdiff_t stride,
+	const JpegOptions& options, const Sink& sink
+)
+{
+	JpegEncoder encoder(width, height, options, sink);
+	encoder.writeRows(pixels, height, stride);
+	encoder.finish();
+}
+
+} //namespace tc::file_as_img::enc
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "VSExportOptions.h"
+#include "VSImageEncoder.h"
+
+namespace tc::file_as_img::enc
+{
+
+///@brief Streaming libjpeg encoder of argb32 rows.
+///
+/// Alpha channel is ignored. With libjpeg-turbo rows are read in place as BGRX or XRGB pixels, other libjpeg
+/// implementations get rows converted to RGB one at a time. Progressive images are buffered by libjpeg
+/// as coefficients until finish().
+class JpegEncoder : public RowEncoder
+{
+public:
+	///@throw tc::err::exc::InvalidArgument on invalid options or empty image.
+	JpegEncoder(std::size_t width, std::size_t height, const JpegOptions& options, Sink sink);
+	JpegEncoder(const JpegEncoder&) = delete;
+	JpegEncoder& operator=(const JpegEncoder&) = delete;
+	~JpegEncoder() override;
+
+	void writeRows(const std::uint8_t* rows, std::size_t count, std::ptrdiff_t stride) override;
+	void finish() override;
+
+	std::size_t width() const override;
+	std::size_t height() const override;
+	std::size_t rowsWritten() const override;
+
+private:
+	struct State;
+	std::unique_ptr<State> m_state;
+};
+
+///@brief Encodes whole image of argb32 rows by JpegEncoder, row i starts at @p pixels + i * @p stride bytes.
+///@throw tc::err::exc::InvalidArgument on invalid options or empty image.
+///@throw std::runtime_error on encoding error, exception thrown by sink is rethrown as is.
+void encodeJpeg(
+	const std::uint8_t* pixels, std::size_t width, std::size_t height, std::ptrdiff_t stride,
+	const JpegOptions& options, const Sink& sink
+);
+
+} //namespace tc::file_as_img::enc
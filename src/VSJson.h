@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+namespace tc::json
+{
+
+///@return @p value as JSON string literal including quotes.
+inline std::string quoted(std::string_view value)
+{
+	std::string result;
+	result.reserve(value.size() + 2);
+	result += '"';
+	for(char c : value)
+	{
+		switch(c)
+		{
+		case '"': result += "\\\""; break;
+		case '\\': result += "\\\\"; break;
+		case '\b': result += "\\b"; break;
+		case '\f': result += "\\f"; break;
+		case '\n': result += "\\n"; break;
+		case '\r': result += "\\r"; break;
+		case '\t': result += "\\t"; break;
+		default:
+			if(static_cast<unsigned char>(c) < 0x20)
+			{
+				char escaped[7];
+				std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+				result += escaped;
+			}
+			else {
+				result += c;
+			}
+		}
+	}
+	result += '"';
+	return result;
+}
+
+} //namespace tc::json
\ No newline at end of file
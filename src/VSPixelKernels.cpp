@@ -0,0 +1,169 @@
+#include "VSPixelKernels.h"
+
+#include <stdexcept>
+
+#if defined(VS_PIXEL_KERNELS_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace tc::pixel
+{
+
+namespace
+{
+
+///@return round(v / 255) for v <= 255 * 255.
+inline std::uint32_t div255(std::uint32_t v)
+{
+	v += 128;
+	return (v + (v >> 8)) >> 8;
+}
+
+inline std::uint32_t channel(std::uint32_t pixel, int shift) {
+	return (pixel >> shift) & 0xFFu;
+}
+
+void flattenOver(std::uint32_t* pixels, std::size_t count, std::uint32_t color)
+{
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		std::uint32_t pixel = pixels[i];
+		std::uint32_t transparency = 255 - (pixel >> 24);
+		std::uint32_t result = 0xFF000000u;
+		for(int shift = 0; shift < 24; shift += 8)
+		{
+			std::uint32_t value = channel(pixel, shift) + div255(channel(color, shift) * transparency);
+			result |= (value > 255 ? 255 : value) << shift;
+		}
+		pixels[i] = result;
+	}
+}
+
+void premultiply(std::uint32_t* pixels, std::size_t count)
+{
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		std::uint32_t pixel = pixels[i];
+		std::uint32_t alpha = pixel >> 24;
+		std::uint32_t result = pixel & 0xFF000000u;
+		for(int shift = 0; shift < 24; shift += 8) {
+			result |= div255(channel(pixel, shift) * alpha) << shift;
+		}
+		pixels[i] = result;
+	}
+}
+
+void argb32ToRgba8888(const std::uint32_t* src, std::uint8_t* dst, std::size_t count)
+{
+	for(std::size_t i = 0; i < count; ++i, dst += 4)
+	{
+		dst[0] = static_cast<std::uint8_t>(channel(src[i], 16));
+		dst[1] = static_cast<std::uint8_t>(channel(src[i], 8));
+		dst[2] = static_cast<std::uint8_t>(channel(src[i], 0));
+		dst[3] = static_cast<std::uint8_t>(channel(src[i], 24));
+	}
+}
+
+void argb32ToRgb888(const std::uint32_t* src, std::uint8_t* dst, std::size_t count)
+{
+	for(std::size_t i = 0; i < count; ++i, dst += 3)
+	{
+		dst[0] = static_cast<std::uint8_t>(channel(src[i], 16));
+		dst[1] = static_cast<std::uint8_t>(channel(src[i], 8));
+		dst[2] = static_cast<std::uint8_t>(channel(src[i], 0));
+	}
+}
+
+const Kernels scalarKernels = {
+	flattenOver,
+	premultiply,
+	argb32ToRgba8888,
+	argb32ToRgb888
+};
+
+#ifdef VS_PIXEL_KERNELS_X86
+
+struct CpuFeatures
+{
+	bool sse41 = false;
+	bool avx2 = false;
+};
+
+CpuFeatures detectCpuFeatures()
+{
+	CpuFeatures features;
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+	__cpuid(info, 1);
+	features.sse41 = (info[2] & (1 << 19)) != 0;
+	bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+	if(maxLeaf >= 7 && osSavesYmm)
+	{
+		__cpuidex(info, 7, 0);
+		features.avx2 = (info[1] & (1 << 5)) != 0;
+	}
+#else
+	__builtin_cpu_init();
+	features.sse41 = __builtin_cpu_supports("sse4.1");
+	features.avx2 = __builtin_cpu_supports("avx2");
+#endif
+	return features;
+}
+
+const CpuFeatures& cpuFeatures()
+{
+	static const CpuFeatures features = detectCpuFeatures();
+	return features;
+}
+
+#endif
+
+}
+
+bool isSupported(Isa isa)
+{
+	switch(isa)
+	{
+	case Isa::Scalar:
+		return true;
+#ifdef VS_PIXEL_KERNELS_X86
+	case Isa::Sse41:
+		return cpuFeatures().sse41;
+	case Isa::Avx2:
+		return cpuFeatures().avx2;
+#endif
+	default:
+		return false;
+	}
+}
+
+const Kernels& kernelsFor(Isa isa)
+{
+	if(!isSupported(isa)) {
+		throw std::invalid_argument("Instruction set is not supported");
+	}
+	switch(isa)
+	{
+#ifdef VS_PIXEL_KERNELS_X86
+	case Isa::Sse41:
+		return detail::sse41Kernels();
+	case Isa::Avx2:
+		return detail::avx2Kernels();
+#endif
+	default:
+		return scalarKernels;
+	}
+}
+
+const Kernels& kernels()
+{
+	static const Kernels& best = kernelsFor(
+		isSupported(Isa::Avx2) ? Isa::Avx2 : isSupported(Isa::Sse41) ? Isa::Sse41 : Isa::Scalar
+	);
+	return best;
+}
+
+} //namespace tc::pixel
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tc::pixel
+{
+
+//Pixel layouts:
+//argb32 - native 32-bit word 0xAARRGGBB, premultiplied or straight alpha depending on context;
+//rgba8888 - bytes R, G, B, A;
+//rgb888 - bytes R, G, B.
+//All kernels process one row of @p count pixels, source and destination must not overlap unless in place.
+
+///@brief Kernels with identical results for every instruction set.
+struct Kernels
+{
+	///@brief Composites premultiplied pixels over opaque @p color in place, produced pixels are opaque.
+	void (*flattenOver)(std::uint32_t* pixels, std::size_t count, std::uint32_t color);
+	///@brief Converts straight alpha pixels to premultiplied ones in place.
+	void (*premultiply)(std::uint32_t* pixels, std::size_t count);
+
+	void (*argb32ToRgba8888)(const std::uint32_t* src, std::uint8_t* dst, std::size_t count);
+	///@brief Drops alpha, pixels are expected to be opaque.
+	void (*argb32ToRgb888)(const std::uint32_t* src, std::uint8_t* dst, std::size_t count);
+};
+
+enum class Isa
+{
+	Scalar,
+	Sse41,
+	Avx2
+};
+
+///@return true if @p isa is compiled in and supported by CPU.
+bool isSupported(Isa isa);
+
+///@pre isSupported(isa).
+const Kernels& kernelsFor(Isa isa);
+
+///@return kernels of the best instruction set supported by CPU, detected once.
+const Kernels& kernels();
+
+namespace detail
+{
+
+//Defined in translation units compiled for corresponding instruction sets.
+const Kernels& sse41Kernels();
+const Kernels& avx2Kernels();
+
+}
+
+} //namespace tc::pixel
\ No newline at end of file
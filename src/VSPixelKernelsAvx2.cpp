@@ -0,0 +1,127 @@
+#include "VSPixelKernels.h"
+
+#include <immintrin.h>
+
+//Compiled with AVX2 enabled, so nothing here may be shared with other translation units
+//and kernels are called only after runtime check. Tails shorter than a vector are processed by scalar kernels.
+//Byte shuffles, unpacks and packs of AVX2 work within 128-bit lanes, masks are repeated for both lanes.
+
+namespace tc::pixel
+{
+
+namespace
+{
+
+const Kernels& scalar() {
+	return kernelsFor(Isa::Scalar);
+}
+
+inline __m256i load(const void* p) {
+	return _mm256_loadu_si256(static_cast<const __m256i*>(p));
+}
+
+inline void store(void* p, __m256i v) {
+	_mm256_storeu_si256(static_cast<__m256i*>(p), v);
+}
+
+inline __m256i laneMask(
+	char b0, char b1, char b2, char b3, char b4, char b5, char b6, char b7,
+	char b8, char b9, char b10, char b11, char b12, char b13, char b14, char b15
+)
+{
+	return _mm256_setr_epi8(
+		b0, b1, b2, b3, b4, b5, b6, b7, b8, b9, b10, b11, b12, b13, b14, b15,
+		b0, b1, b2, b3, b4, b5, b6, b7, b8, b9, b10, b11, b12, b13, b14, b15
+	);
+}
+
+///@return round(v / 255) for every 16-bit lane, v <= 255 * 255.
+inline __m256i div255(__m256i v)
+{
+	v = _mm256_add_epi16(v, _mm256_set1_epi16(128));
+	return _mm256_srli_epi16(_mm256_add_epi16(v, _mm256_srli_epi16(v, 8)), 8);
+}
+
+inline __m256i alphaMask() {
+	return _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+}
+
+///@return alpha of every pixel repeated in all its bytes.
+inline __m256i broadcastAlpha(__m256i pixels) {
+	return _mm256_shuffle_epi8(pixels, laneMask(3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15));
+}
+
+///@return 8-bit lanes of @p a and @p b multiplied and divided by 255.
+inline __m256i mulDiv255(__m256i a, __m256i b)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i lo = div255(_mm256_mullo_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero)));
+	__m256i hi = div255(_mm256_mullo_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero)));
+	return _mm256_packus_epi16(lo, hi);
+}
+
+void flattenOver(std::uint32_t* pixels, std::size_t count, std::uint32_t color)
+{
+	const __m256i colors = _mm256_set1_epi32(static_cast<int>(color | 0xFF000000u));
+	std::size_t i = 0;
+	for(; i + 8 <= count; i += 8)
+	{
+		__m256i p = load(pixels + i);
+		__m256i transparency = _mm256_xor_si256(broadcastAlpha(p), _mm256_set1_epi8(-1));
+		store(pixels + i, _mm256_or_si256(_mm256_adds_epu8(p, mulDiv255(transparency, colors)), alphaMask()));
+	}
+	scalar().flattenOver(pixels + i, count - i, color);
+}
+
+void premultiply(std::uint32_t* pixels, std::size_t count)
+{
+	std::size_t i = 0;
+	for(; i + 8 <= count; i += 8)
+	{
+		__m256i p = load(pixels + i);
+		store(pixels + i, mulDiv255(p, _mm256_or_si256(broadcastAlpha(p), alphaMask())));
+	}
+	scalar().premultiply(pixels + i, count - i);
+}
+
+void argb32ToRgba8888(const std::uint32_t* src, std::uint8_t* dst, std::size_t count)
+{
+	const __m256i swapRB = laneMask(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+	std::size_t i = 0;
+	for(; i + 8 <= count; i += 8) {
+		store(dst + i * 4, _mm256_shuffle_epi8(load(src + i), swapRB));
+	}
+	scalar().argb32ToRgba8888(src + i, dst + i * 4, count - i);
+}
+
+void argb32ToRgb888(const std::uint32_t* src, std::uint8_t* dst, std::size_t count)
+{
+	const __m256i pack = laneMask(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	const __m256i joinLanes = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+	std::size_t i = 0;
+	//Every store writes 32 bytes of which 24 are produced, so the last vector is left to scalar tail.
+	for(; i + 11 <= count; i += 8) {
+		store(dst + i * 3, _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(load(src + i), pack), joinLanes));
+	}
+	scalar().argb32ToRgb888(src + i, dst + i * 3, count - i);
+}
+
+const Kernels avx2 = {
+	flattenOver,
+	premultiply,
+	argb32ToRgba8888,
+	argb32ToRgb888
+};
+
+}
+
+namespace detail
+{
+
+const Kernels& avx2Kernels() {
+	return avx2;
+}
+
+}
+
+} //namespace tc::pixel
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "VSPixelKernels.h"
+
+#include <smmintrin.h>
+
+//Compiled with SSE4.1 enabled, so nothing here may be shared with other translation units
+//and kernels are called only after runtime check. Tails shorter than a vector are processed by scalar kernels.
+
+namespace tc::pixel
+{
+
+namespace
+{
+
+const Kernels& scalar() {
+	return kernelsFor(Isa::Scalar);
+}
+
+inline __m128i load(const void* p) {
+	return _mm_loadu_si128(static_cast<const __m128i*>(p));
+}
+
+inline void store(void* p, __m128i v) {
+	_mm_storeu_si128(static_cast<__m128i*>(p), v);
+}
+
+///@return round(v / 255) for every 16-bit lane, v <= 255 * 255.
+inline __m128i div255(__m128i v)
+{
+	v = _mm_add_epi16(v, _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+}
+
+inline __m128i alphaMask() {
+	return _mm_set1_epi32(static_cast<int>(0xFF000000u));
+}
+
+///@return alpha of every pixel repeated in all its bytes.
+inline __m128i broadcastAlpha(__m128i pixels) {
+	return _mm_shuffle_epi8(pixels, _mm_setr_epi8(3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15));
+}
+
+///@return 8-bit lanes of @p a and @p b multiplied and divided by 255.
+inline __m128i mulDiv255(__m128i a, __m128i b)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i lo = div255(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)));
+	__m128i hi = div255(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)));
+	return _mm_packus_epi16(lo, hi);
+}
+
+void flattenOver(std::uint32_t* pixels, std::size_t count, std::uint32_t color)
+{
+	const __m128i colors = _mm_set1_epi32(static_cast<int>(color | 0xFF000000u));
+	std::size_t i = 0;
+	for(; i + 4 <= count; i += 4)
+	{
+		__m128i p = load(pixels + i);
+		__m128i transparency = _mm_xor_si128(broadcastAlpha(p), _mm_set1_epi8(-1));
+		store(pixels + i, _mm_or_si128(_mm_adds_epu8(p, mulDiv255(transparency, colors)), alphaMask()));
+	}
+	scalar().flattenOver(pixels + i, count - i, color);
+}
+
+void premultiply(std::uint32_t* pixels, std::size_t count)
+{
+	std::size_t i = 0;
+	for(; i + 4 <= count; i += 4)
+	{
+		__m128i p = load(pixels + i);
+		store(pixels + i, mulDiv255(p, _mm_or_si128(broadcastAlpha(p), alphaMask())));
+	}
+	scalar().premultiply(pixels + i, count - i);
+}
+
+void argb32ToRgba8888(const std::uint32_t* src, std::uint8_t* dst, std::size_t count)
+{
+	const __m128i swapRB = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+	std::size_t i = 0;
+	for(; i + 4 <= count; i += 4) {
+		store(dst + i * 4, _mm_shuffle_epi8(load(src + i), swapRB));
+	}
+	scalar().argb32ToRgba8888(src + i, dst + i * 4, count - i);
+}
+
+void argb32ToRgb888(const std::uint32_t* src, std::uint8_t* dst, std::size_t count)
+{
+	const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	std::size_t i = 0;
+	//Every store writes 16 bytes of which 12 are produced, so the last vector is left to scalar tail.
+	for(; i + 6 <= count; i += 4) {
+		store(dst + i * 3, _mm_shuffle_epi8(load(src + i), pack));
+	}
+	scalar().argb32ToRgb888(src + i, dst + i * 3, count - i);
+}
+
+const Kernels sse41 = {
+	flattenOver,
+	premultiply,
+	argb32ToRgba8888,
+	argb32ToRgb888
+};
+
+}
+
+namespace detail
+{
+
+const Kernels& sse41Kernels() {
+	return sse41;
+}
+
+}
+
+} //namespace tc::pixel
\ No newline at end of file
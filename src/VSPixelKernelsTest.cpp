@@ -0,0 +1,149 @@
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "VSPixelKernels.h"
+
+//Checks that every kernel of every SIMD instruction set supported by CPU produces bytes identical to scalar kernel.
+//Rows have widths of every tail length 0..31 after vector bodies of 0, 32 and 256 pixels, and start at aligned
+//and unaligned addresses. Pixels are random with edge values of channels mixed in, kernels of premultiplied pixels
+//get valid premultiplied pixels. Exit status is number of failed checks.
+
+namespace
+{
+
+using tc::pixel::Isa;
+using tc::pixel::Kernels;
+
+const std::size_t bodies[] = {0, 32, 256};
+const std::size_t maxTail = 31;
+//Rows start this many pixels past beginning of buffer to test unaligned loads and stores.
+const std::size_t offsets[] = {0, 1};
+
+std::mt19937 generator(12345);
+
+std::uint8_t randomChannel()
+{
+	static const std::uint8_t edges[] = {0, 1, 127, 128, 254, 255};
+	std::uint32_t value = generator();
+	return value % 4 == 0 ? edges[(value >> 8) % std::size(edges)] : static_cast<std::uint8_t>(value >> 16);
+}
+
+std::vector<std::uint32_t> randomPixels(std::size_t count, bool premultiplied)
+{
+	std::vector<std::uint32_t> pixels(count);
+	for(std::uint32_t& pixel : pixels)
+	{
+		std::uint32_t alpha = randomChannel();
+		pixel = alpha << 24;
+		for(int shift = 0; shift < 24; shift += 8)
+		{
+			std::uint32_t value = randomChannel();
+			pixel |= (premultiplied ? value * alpha / 255 : value) << shift;
+		}
+	}
+	return pixels;
+}
+
+std::string nameOf(Isa isa)
+{
+	return isa == Isa::Sse41 ? "sse4.1" : "avx2";
+}
+
+int failures = 0;
+
+void expectEqual(const void* expected, const void* actual, std::size_t size, const std::string& what)
+{
+	if(size && std::memcmp(expected, actual, size) != 0)
+	{
+		++failures;
+		std::cerr << "FAILED " << what << std::endl;
+	}
+}
+
+///@brief Calls @p run with every width and offset of rows and description of the check.
+template<typename Run>
+void checkRows(const std::string& kernel, Isa isa, Run run)
+{
+	for(std::size_t body : bodies)
+	{
+		for(std::size_t tail = 0; tail <= maxTail; ++tail)
+		{
+			for(std::size_t offset : offsets) {
+				run(body + tail, offset, kernel + "/" + nameOf(isa) + " width " + std::to_string(body + tail) +
+					" offset " + std::to_string(offset));
+			}
+		}
+	}
+}
+
+template<typename Kernel>
+void checkPixelsInPlace(const std::string& kernel, Isa isa, Kernel Kernels::* member, bool premultiplied)
+{
+	const Kernels& scalar = tc::pixel::kernelsFor(Isa::Scalar);
+	const Kernels& simd = tc::pixel::kernelsFor(isa);
+	checkRows(kernel, isa, [&](std::size_t width, std::size_t offset, const std::string& what) {
+		std::vector<std::uint32_t> expected = randomPixels(width + offset, premultiplied);
+		std::vector<std::uint32_t> actual = expected;
+		if constexpr(std::is_same_v<Kernel, void (*)(std::uint32_t*, std::size_t, std::uint32_t)>)
+		{
+			std::uint32_t color = randomPixels(1, false)[0] | 0xFF000000u;
+			(scalar.*member)(expected.data() + offset, width, color);
+			(simd.*member)(actual.data() + offset, width, color);
+		}
+		else
+		{
+			(scalar.*member)(expected.data() + offset, width);
+			(simd.*member)(actual.data() + offset, width);
+		}
+		expectEqual(expected.data(), actual.data(), expected.size() * 4, what);
+	});
+}
+
+void checkFromArgb32(
+	const std::string& kernel, Isa isa, void (*Kernels::* member)(const std::uint32_t*, std::uint8_t*, std::size_t),
+	std::size_t bytesPerPixel
+)
+{
+	const Kernels& scalar = tc::pixel::kernelsFor(Isa::Scalar);
+	const Kernels& simd = tc::pixel::kernelsFor(isa);
+	checkRows(kernel, isa, [&](std::size_t width, std::size_t offset, const std::string& what) {
+		std::vector<std::uint32_t> src = randomPixels(width + offset, false);
+		//Guard bytes past the row catch stores beyond it.
+		std::vector<std::uint8_t> expected((width + offset) * bytesPerPixel + 64, 0xA5);
+		std::vector<std::uint8_t> actual = expected;
+		(scalar.*member)(src.data() + offset, expected.data() + offset * bytesPerPixel, width);
+		(simd.*member)(src.data() + offset, actual.data() + offset * bytesPerPixel, width);
+		expectEqual(expected.data(), actual.data(), expected.size(), what);
+	});
+}
+
+}
+
+int main()
+{
+	bool checked = false;
+	for(Isa isa : {Isa::Sse41, Isa::Avx2})
+	{
+		if(!tc::pixel::isSupported(isa))
+		{
+			std::cout << "Skipped " << nameOf(isa) << ", it is not supported" << std::endl;
+			continue;
+		}
+		checked = true;
+		checkPixelsInPlace("flattenOver", isa, &Kernels::flattenOver, true);
+		checkPixelsInPlace("premultiply", isa, &Kernels::premultiply, false);
+		checkFromArgb32("argb32ToRgba8888", isa, &Kernels::argb32ToRgba8888, 4);
+		checkFromArgb32("argb32ToRgb888", isa, &Kernels::argb32ToRgb888, 3);
+		std::cout << "Checked " << nameOf(isa) << std::endl;
+	}
+	if(!checked) {
+		std::cout << "No SIMD kernels to check" << std::endl;
+	}
+	return failures;
+}
@@ -0,0 +1,232 @@
+#include "VSPngEncoder.h"
+
+#include <cassert>
+#include <csetjmp>
+#include <cstring>
+#include <exception>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <png.h>
+#include <zlib.h>
+
+namespace tc::file_as_img::enc
+{
+
+namespace
+{
+
+bool isLittleEndian()
+{
+	const std::uint32_t one = 1;
+	std::uint8_t firstByte;
+	std::memcpy(&firstByte, &one, 1);
+	return firstByte == 1;
+}
+
+int filtersOf(PngOptions::Filter filter)
+{
+	switch(filter)
+	{
+	case PngOptions::Filter::None: return PNG_FILTER_NONE;
+	case PngOptions::Filter::Sub: return PNG_FILTER_SUB;
+	case PngOptions::Filter::Up: return PNG_FILTER_UP;
+	case PngOptions::Filter::Average: return PNG_FILTER_AVG;
+	case PngOptions::Filter::Paeth: return PNG_FILTER_PAETH;
+	case PngOptions::Filter::Adaptive: return PNG_ALL_FILTERS;
+	}
+	throw tc::err::exc::InvalidArgument("Invalid png filter");
+}
+
+int zlibStrategyOf(PngOptions::Strategy strategy)
+{
+	switch(strategy)
+	{
+	case PngOptions::Strategy::Default: return Z_DEFAULT_STRATEGY;
+	case PngOptions::Strategy::Filtered: return Z_FILTERED;
+	case PngOptions::Strategy::HuffmanOnly: return Z_HUFFMAN_ONLY;
+	case PngOptions::Strategy::Rle: return Z_RLE;
+	case PngOptions::Strategy::Fixed: return Z_FIXED;
+	}
+	throw tc::err::exc::InvalidArgument("Invalid png strategy");
+}
+
+}
+
+//libpng reports errors by longjmp, so they are recorded here and turned into exceptions after setjmp returns,
+//no exception is thrown through libpng frames.
+struct PngEncoder::State
+{
+	png_structp png = nullptr;
+	png_infop info = nullptr;
+	Sink sink;
+	std::size_t width = 0;
+	std::size_t height = 0;
+	std::size_t rowsWritten = 0;
+	bool failed = false;
+	std::string error;
+	std::exception_ptr sinkError;
+
+	~State() {
+		png_destroy_write_struct(&png, &info);
+	}
+
+	[[noreturn]] void rethrow()
+	{
+		failed = true;
+		if(sinkError) {
+			std::rethrow_exception(sinkError);
+		}
+		throw std::runtime_error("Png encoding error: " + error);
+	}
+
+	static State& of(png_structp png) {
+		return *static_cast<State*>(png_get_io_ptr(png));
+	}
+
+	static void onError(png_structp png, png_const_charp message)
+	{
+		auto* state = static_cast<State*>(png_get_error_ptr(png));
+		state->error = message ? message : "unknown";
+		png_longjmp(png, 1);
+	}
+
+	static void onWarning(png_structp, png_const_charp)
+	{}
+
+	static void onWrite(png_structp png, png_bytep data, png_size_t size)
+	{
+		State& state = of(png);
+		try {
+			state.sink(data, size);
+		}
+		catch(...) {
+			state.sinkError = std::current_exception();
+		}
+		//Jump must not leave catch block, exception would never be released.
+		if(state.sinkError) {
+			png_error(png, "sink has failed");
+		}
+	}
+
+	static void onFlush(png_structp)
+	{}
+};
+
+PngEncoder::PngEncoder(std::size_t width, std::size_t height, bool alpha, const PngOptions& options, Sink sink) :
+	m_state(std::make_unique<State>())
+{
+	if(width == 0 || height == 0 || width > PNG_USER_WIDTH_MAX || height > PNG_USER_HEIGHT_MAX) {
+		throw tc::err::exc::InvalidArgument("Invalid size of png image");
+	}
+	if(options.compressionLevel < Z_NO_COMPRESSION || options.compressionLevel > Z_BEST_COMPRESSION) {
+		throw tc::err::exc::InvalidArgument("Invalid png compression level");
+	}
+	assert(sink);
+	int filters = filtersOf(options.filter);
+	int strategy = zlibStrategyOf(options.strategy);
+
+	State& state = *m_state;
+	state.sink = std::move(sink);
+	state.width = width;
+	state.height = height;
+	state.png = png_create_write_struct(PNG_LIBPNG_VER_STRING, &state, &State::onError, &State::onWarning);
+	if(!state.png) {
+		throw std::bad_alloc();
+	}
+	state.info = png_create_info_struct(state.png);
+	if(!state.info) {
+		throw std::bad_alloc();
+	}
+	if(setjmp(png_jmpbuf(state.png))) {
+		state.rethrow();
+	}
+	png_set_write_fn(state.png, &state, &State::onWrite, &State::onFlush);
+	png_set_compression_level(state.png, options.compressionLevel);
+	png_set_compression_strategy(state.png, strategy);
+	png_set_filter(state.png, PNG_FILTER_TYPE_BASE, filters);
+	png_set_IHDR(
+		state.png, state.info,
+		static_cast<png_uint_32>(width), static_cast<png_uint_32>(height), 8,
+		alpha ? PNG_COLOR_TYPE_RGB_ALPHA : PNG_COLOR_TYPE_RGB,
+		PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE
+	);
+	png_write_info(state.png, state.info);
+	//argb32 words are B, G, R, A bytes on little endian and A, R, G, B bytes on big endian machines.
+	if(isLittleEndian())
+	{
+		png_set_bgr(state.png);
+		if(!alpha) {
+			png_set_filler(state.png, 0, PNG_FILLER_AFTER);
+		}
+	}
+	else
+	{
+		if(alpha) {
+			png_set_swap_alpha(state.png);
+		}
+		else {
+			png_set_filler(state.png, 0, PNG_FILLER_BEFORE);
+		}
+	}
+}
+
+PngEncoder::~PngEncoder() = default;
+
+void PngEncoder::writeRows(const std::uint8_t* rows, std::size_t count, std::ptrdiff_t stride)
+{
+	State& state = *m_state;
+	if(state.failed) {
+		throw std::logic_error("Png encoder has failed");
+	}
+	assert(state.rowsWritten + count <= state.height);
+	if(setjmp(png_jmpbuf(state.png))) {
+		state.rethrow();
+	}
+	for(std::size_t i = 0; i < count; ++i) {
+		png_write_row(state.png, rows + static_cast<std::ptrdiff_t>(i) * stride);
+	}
+	state.rowsWritten += count;
+}
+
+void PngEncoder::finish()
+{
+	State& state = *m_state;
+	if(state.failed) {
+		throw std::logic_error("Png encoder has failed");
+	}
+	assert(state.rowsWritten == state.height);
+	if(setjmp(png_jmpbuf(state.png))) {
+		state.rethrow();
+	}
+	png_write_end(state.png, nullptr);
+}
+
+std::size_t PngEncoder::width() const
+{
+	return m_state->width;
+}
+
+std::size_t PngEncoder::height() const
+{
+	return m_state->height;
+}
+
+std::size_t PngEncoder::rowsWritten() const
+{
+	return m_state->rowsWritten;
+}
+
+void encodePng(
+	const std::uint8_t* pixels, std::size_t width, std::size_t height, std::ptrdiff_t stride, bool alpha,
+	const PngOptions& options, const Sink& sink
+)
+{
+	PngEncoder encoder(width, height, alpha, options, sink);
+	encoder.writeRows(pixels, height, stride);
+	encoder.finish();
+}
+
+} //namespace tc::file_as_img::enc
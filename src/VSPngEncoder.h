@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "VSExportOptions.h"
+#include "VSImageEncoder.h"
+
+namespace tc::file_as_img::enc
+{
+
+///@brief Streaming libpng encoder of argb32 rows.
+///
+/// Rows are filtered and compressed as they are written, so image may be encoded band by band without being
+/// complete in memory, and output is passed to sink in chunks. Pixels are read in place, byte order of argb32
+/// is handled by libpng transformations, no converted copy of image is made.
+class PngEncoder : public RowEncoder
+{
+public:
+	///@param alpha false writes RGB image and ignores alpha channel of rows, which is faster and smaller for opaque images.
+	///@throw tc::err::exc::InvalidArgument on invalid options or empty image.
+	PngEncoder(std::size_t width, std::size_t height, bool alpha, const PngOptions& options, Sink sink);
+	PngEncoder(const PngEncoder&) = delete;
+	PngEncoder& operator=(const PngEncoder&) = delete;
+	~PngEncoder() override;
+
+	void writeRows(const std::uint8_t* rows, std::size_t count, std::ptrdiff_t stride) override;
+	void finish() override;
+
+	std::size_t width() const override;
+	std::size_t height() const override;
+	std::size_t rowsWritten() const override;
+
+private:
+	struct State;
+	std::unique_ptr<State> m_state;
+};
+
+///@brief Encodes whole image of argb32 rows by PngEncoder.
+void encodePng(
+	const std::uint8_t* pixels, std::size_t width, std::size_t height, std::ptrdiff_t stride, bool alpha,
+	const PngOptions& options, const Sink& sink
+);
+
+} //namespace tc::file_as_img::enc
@@ -2,9 +2,532 @@
 
 #include <cassert>
 #include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/algorithm/string/split.hpp>
+#include <boost/lexical_cast.hpp>
 
 #include <QtPdf/QPdfDocument>
-#include <QPainter>
+#include <QtPdf/QPdfDocumentRenderOptions>
+#include <QBuffer>
+#include <QtGlobal>
+
+#include "VSExportPipeline.h"
+#include "VSPixelKernels.h"
+#include "VSImageEncoder.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define VS_PDF_WORKER_PROCESSES
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace
+{
+
+//QtPdf serializes all pdfium calls by its own global mutex, so threads can not render pages concurrently and
+//parallel rendering is done by worker processes. Every QPdfDocument of this file is created, used and destroyed
+//under this mutex, so threads of this process do not wait for each other inside pdfium.
+std::recursive_mutex pdfiumMutex;
+
+//Executable started with VSQtPdfManager::pageWorkerArgument to render pages in worker process, empty if there is none.
+tc::stdfs::path workerExecutable;
+
+struct PdfDocumentDeleter
+{
+	void operator()(QPdfDocument* doc) const {
+		std::lock_guard lock(pdfiumMutex);
+		delete doc;
+	}
+};
+
+using PdfDocumentPtr = std::unique_ptr<QPdfDocument, PdfDocumentDeleter>;
+
+PdfDocumentPtr loadPdfDocument(const tc::stdfs::path& file)
+{
+	std::lock_guard lock(pdfiumMutex);
+	PdfDocumentPtr doc(new QPdfDocument());
+	QPdfDocument::DocumentError err = doc->load(QString::fromStdString(file.string()));
+	if(err != decltype(err)::NoError) {
+		throw std::runtime_error("QPdfDocument load error " + std::to_string(err));
+	}
+	return doc;
+}
+
+int pageCountOf(QPdfDocument& doc)
+{
+	std::lock_guard lock(pdfiumMutex);
+	return doc.pageCount();
+}
+
+///@brief Converts Format_ARGB32 @p image by pixel kernels into buffer drawn from @p pool if it is given,
+/// other conversions are left to QImage.
+void convertPixels(QImage& image, QImage::Format format, tc::file_as_img::mem::BufferPool* pool)
+{
+	using Buffer = tc::file_as_img::mem::BufferPool::Buffer;
+	void (*convertRow)(const std::uint32_t*, std::uint8_t*, std::size_t) = nullptr;
+	int bytesPerPixel = 4;
+	if(image.format() == QImage::Format_ARGB32 && format == QImage::Format_RGBA8888) {
+		convertRow = tc::pixel::kernels().argb32ToRgba8888;
+	}
+	else if(image.format() == QImage::Format_ARGB32 && format == QImage::Format_RGB888)
+	{
+		convertRow = tc::pixel::kernels().argb32ToRgb888;
+		bytesPerPixel = 3;
+	}
+	if(!convertRow)
+	{
+		image.convertTo(format);
+		return;
+	}
+	QImage converted;
+	if(pool)
+	{
+		int bytesPerLine = (image.width() * bytesPerPixel + 3) & ~3;
+		auto* buffer = new Buffer(pool->acquire(static_cast<std::size_t>(bytesPerLine) * image.height()));
+		converted = QImage(
+			reinterpret_cast<uchar*>(buffer->get()), image.width(), image.height(), bytesPerLine, format,
+			[](void* info) {
+				delete static_cast<Buffer*>(info);
+			},
+			buffer
+		);
+	}
+	else {
+		converted = QImage(image.size(), format);
+	}
+	for(int y = 0; y < image.height(); ++y) {
+		convertRow(reinterpret_cast<const std::uint32_t*>(image.constScanLine(y)), converted.scanLine(y), image.width());
+	}
+	image = std::move(converted);
+}
+
+///@brief Maps @p options to pdfium render flags, text hinting is left to pdfium as QtPdf does not expose it.
+QPdfDocumentRenderOptions renderOptionsOf(const tc::file_as_img::RenderOptions& options)
+{
+	QPdfDocumentRenderOptions result;
+	if(!options.antialiasing) {
+		result.setRenderFlags(QPdf::RenderTextAliased | QPdf::RenderImageAliased | QPdf::RenderPathAliased);
+	}
+	return result;
+}
+
+///@return pixel size of @p page rendered at dpi of @p options or directly at size fitting in their box.
+QSize pixelSizeOf(QPdfDocument& doc, int page, const tc::file_as_img::ExportOptions& options)
+{
+	std::lock_guard lock(pdfiumMutex);
+	QSizeF pageSize = doc.pageSize(page);
+	auto [width, height] = tc::file_as_img::pixelSizeOf(options, pageSize.width(), pageSize.height());
+	return QSize(width, height);
+}
+
+///@brief Renders @p page of @p file at dpi of @p options or directly at size fitting in their box.
+QImage renderPage(QPdfDocument& doc, int page, const tc::file_as_img::ExportOptions& options, const tc::stdfs::path& file)
+{
+	using tc::file_as_img::Stage;
+	QSize size = pixelSizeOf(doc, page, options);
+	tc::file_as_img::StageTimer renderTimer(options.observer.get(), Stage::Render, file, page);
+	QImage img;
+	{
+		std::lock_guard lock(pdfiumMutex);
+		img = doc.render(page, size, renderOptionsOf(options.render));
+	}
+	if(img.isNull()) {
+		throw std::runtime_error("Unable to render pdf page");
+	}
+	std::uint64_t pixels = std::uint64_t(img.width()) * img.height();
+	renderTimer.finish(pixels);
+	tc::file_as_img::StageTimer convertTimer(options.observer.get(), Stage::Convert, file, page);
+	VSQtPdfManager::flattenOver(img, options.render.background);
+	convertTimer.finish(pixels);
+	assert(!img.isNull());
+	return img;
+}
+
+///@brief Renders @p rowCount rows of @p page of @p file rendered at @p pageSize starting at row @p top.
+QImage renderBand(
+	QPdfDocument& doc, int page, const tc::file_as_img::ExportOptions& options, const tc::stdfs::path& file,
+	QSize pageSize, int top, int rowCount
+)
+{
+	using tc::file_as_img::Stage;
+	tc::file_as_img::StageTimer renderTimer(options.observer.get(), Stage::Render, file, page);
+	QImage img;
+	{
+		std::lock_guard lock(pdfiumMutex);
+		QPdfDocumentRenderOptions renderOptions = renderOptionsOf(options.render);
+		renderOptions.setScaledSize(pageSize);
+		renderOptions.setScaledClipRect(QRect(0, top, pageSize.width(), rowCount));
+		img = doc.render(page, QSize(pageSize.width(), rowCount), renderOptions);
+	}
+	if(img.isNull()) {
+		throw std::runtime_error("Unable to render pdf page");
+	}
+	std::uint64_t pixels = std::uint64_t(img.width()) * img.height();
+	renderTimer.finish(pixels);
+	tc::file_as_img::StageTimer convertTimer(options.observer.get(), Stage::Convert, file, page);
+	VSQtPdfManager::flattenOver(img, options.render.background);
+	convertTimer.finish(pixels);
+	return img;
+}
+
+///@brief Image of @p page filled with background colour, which is exported in place of page exceeding its budget.
+QImage placeholderOf(QPdfDocument& doc, int page, const tc::file_as_img::ExportOptions& options)
+{
+	QImage img(pixelSizeOf(doc, page, options), QImage::Format_ARGB32);
+	img.fill(0xFF000000u | options.render.background);
+	return img;
+}
+
+///@brief Page passed between stages of export pipeline.
+struct RenderedPage
+{
+	QImage image;
+	int page;
+};
+
+struct EncodedPage
+{
+	QByteArray bytes;
+	int page;
+};
+
+#ifdef VS_PDF_WORKER_PROCESSES
+
+///@brief Renders pages of pdf file in worker processes, worker i renders pages[i], pages[i + N], pages[i + 2N], ...
+/// and sends them through its pipe, so pages are received in order by reading workers round-robin.
+///
+/// Workers are spawned as workerExecutable with pageWorkerArgument, which runs runPageWorker() in a fresh image,
+/// rather than forked, as forked copy of multithreaded process may inherit locks of Qt or pdfium held by other threads.
+/// Request is passed by arguments of worker, pages are read from its standard output.
+class PageWorkerProcesses
+{
+public:
+	///@brief Arguments of worker following pageWorkerArgument.
+	enum Argument
+	{
+		FileArgument,
+		DpiArgument,
+		FitWidthArgument,
+		FitHeightArgument,
+		AntialiasingArgument,
+		BackgroundArgument,
+		PagesArgument,
+		ArgumentCount
+	};
+
+	PageWorkerProcesses() = default;
+	PageWorkerProcesses(const PageWorkerProcesses&) = delete;
+	PageWorkerProcesses& operator=(const PageWorkerProcesses&) = delete;
+
+	~PageWorkerProcesses()
+	{
+		for(Worker& worker : m_workers) {
+			stop(worker);
+		}
+	}
+
+	static bool isAvailable() {
+		return !workerExecutable.empty();
+	}
+
+	void start(
+		const tc::stdfs::path& file, const std::vector<int>& pages, const tc::file_as_img::ExportOptions& options,
+		std::size_t workerCount
+	)
+	{
+		assert(isAvailable());
+		assert(m_workers.empty());
+		assert(workerCount > 0);
+		m_file = file;
+		m_pages = pages;
+		m_options = options;
+		m_workerCount = workerCount;
+		for(std::size_t i = 0; i < workerCount; ++i) {
+			m_workers.push_back(spawn(i));
+		}
+	}
+
+	///@brief Kills worker rendering page at @p pageIndex, which is not received, and starts new worker
+	/// rendering the rest of its pages, so receiving continues with page at @p pageIndex + 1.
+	void skip(std::size_t pageIndex)
+	{
+		Worker& worker = m_workers[pageIndex % m_workerCount];
+		stop(worker);
+		worker = spawn(pageIndex + m_workerCount);
+	}
+
+	struct ReceivedPage
+	{
+		QImage image;
+		///@brief Duration of convert stage of page measured by worker.
+		std::chrono::nanoseconds convertDuration{0};
+	};
+
+	ReceivedPage receive(std::size_t pageIndex, const std::function<void()>& checkInterrupt)
+	{
+		assert(!m_workers.empty());
+		int fd = m_workers[pageIndex % m_workers.size()].fd;
+		PageHeader header;
+		read(fd, &header, sizeof(header), checkInterrupt);
+		if(header.width < 0)
+		{
+			std::string message(static_cast<std::size_t>(std::max(header.bytesPerLine, 0)), '\0');
+			read(fd, message.data(), message.size(), checkInterrupt);
+			throw std::runtime_error(message);
+		}
+		QImage img(header.width, header.height, static_cast<QImage::Format>(header.format));
+		if(img.isNull() || img.bytesPerLine() != header.bytesPerLine) {
+			throw std::runtime_error("Invalid page has been received from pdf worker process");
+		}
+		read(fd, img.bits(), static_cast<std::size_t>(img.sizeInBytes()), checkInterrupt);
+		return {std::move(img), std::chrono::nanoseconds(header.convertNanoseconds)};
+	}
+
+	///@brief Waits for all workers to exit after all pages have been received.
+	void join()
+	{
+		for(Worker& worker : m_workers)
+		{
+			if(worker.pid <= 0) {
+				continue;
+			}
+			int status = waitFor(worker.pid);
+			worker.pid = -1;
+			if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+				throw std::runtime_error("Pdf worker process has failed");
+			}
+		}
+	}
+
+	///@brief Renders pages requested by worker @p arguments to @p fd.
+	///@return exit status of worker.
+	static int run(const std::vector<std::string>& arguments, int fd)
+	{
+		int status = 0;
+		try
+		{
+			if(arguments.size() != ArgumentCount) {
+				throw std::runtime_error("Invalid arguments of pdf worker process");
+			}
+			tc::stdfs::path file = arguments[FileArgument];
+			tc::file_as_img::ExportOptions options;
+			options.dpi = boost::lexical_cast<tc::file_as_img::ExportOptions::DPI>(arguments[DpiArgument]);
+			options.fitWithin.width = boost::lexical_cast<std::size_t>(arguments[FitWidthArgument]);
+			options.fitWithin.height = boost::lexical_cast<std::size_t>(arguments[FitHeightArgument]);
+			options.render.antialiasing = arguments[AntialiasingArgument] == "1";
+			options.render.background = boost::lexical_cast<std::uint32_t>(arguments[BackgroundArgument]);
+			std::vector<std::string> pages;
+			boost::algorithm::split(pages, arguments[PagesArgument], [](char c) { return c == ','; });
+
+			//Exporting process only sees pages arrive, so convert stage of every page is measured here and sent with it.
+			auto convertDuration = std::make_shared<ConvertDurationObserver>();
+			options.observer = convertDuration;
+
+			PdfDocumentPtr doc = loadPdfDocument(file);
+			for(const std::string& page : pages)
+			{
+				QImage img = renderPage(*doc, boost::lexical_cast<int>(page), options, file);
+				PageHeader header{
+					img.width(), img.height(), static_cast<std::int32_t>(img.bytesPerLine()), img.format(),
+					convertDuration->nanoseconds
+				};
+				if(!write(fd, &header, sizeof(header)) ||
+					!write(fd, img.constBits(), static_cast<std::size_t>(img.sizeInBytes())))
+				{
+					status = 1;
+					break;
+				}
+			}
+		}
+		catch(const std::exception& e)
+		{
+			std::string message = e.what();
+			PageHeader header{-1, 0, static_cast<std::int32_t>(message.size()), 0, 0};
+			write(fd, &header, sizeof(header)) && write(fd, message.data(), message.size());
+			status = 1;
+		}
+		return status;
+	}
+
+private:
+	struct PageHeader
+	{
+		//negative width means error, its message of bytesPerLine length follows.
+		std::int32_t width;
+		std::int32_t height;
+		std::int32_t bytesPerLine;
+		std::int32_t format;
+		std::int64_t convertNanoseconds;
+	};
+
+	///@brief Keeps duration of the last convert stage reported by renderPage() in worker process.
+	struct ConvertDurationObserver : tc::file_as_img::IExportObserver
+	{
+		void onStage(const tc::file_as_img::StageEvent& event) override
+		{
+			if(event.stage == tc::file_as_img::Stage::Convert) {
+				nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(event.end - event.start).count();
+			}
+		}
+
+		std::int64_t nanoseconds = 0;
+	};
+
+	struct Worker
+	{
+		pid_t pid = -1;
+		int fd = -1;
+	};
+
+	///@brief Creates pipe whose ends are closed in spawned processes unless they are duplicated to their descriptors.
+	static void createPipe(int fds[2])
+	{
+#ifdef __linux__
+		if(::pipe2(fds, O_CLOEXEC) != 0) {
+			throw std::runtime_error("Unable to create pipe for pdf worker process");
+		}
+#else
+		//Without pipe2 descriptors may leak to processes spawned by other threads in between, which only delays
+		//their end of file.
+		if(::pipe(fds) != 0) {
+			throw std::runtime_error("Unable to create pipe for pdf worker process");
+		}
+		::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+		::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#endif
+	}
+
+	///@brief Spawns worker rendering pages at indices @p first, @p first + N, @p first + 2N, ...
+	///@return worker without process if there are no such pages.
+	Worker spawn(std::size_t first)
+	{
+		if(first >= m_pages.size()) {
+			return {};
+		}
+		std::string pages;
+		for(std::size_t page = first; page < m_pages.size(); page += m_workerCount) {
+			pages += (pages.empty() ? "" : ",") + std::to_string(m_pages[page]);
+		}
+		std::vector<std::string> arguments(ArgumentCount);
+		arguments[FileArgument] = m_file.string();
+		arguments[DpiArgument] = boost::lexical_cast<std::string>(m_options.dpi);
+		arguments[FitWidthArgument] = std::to_string(m_options.fitWithin.width);
+		arguments[FitHeightArgument] = std::to_string(m_options.fitWithin.height);
+		arguments[AntialiasingArgument] = m_options.render.antialiasing ? "1" : "0";
+		arguments[BackgroundArgument] = std::to_string(m_options.render.background);
+		arguments[PagesArgument] = std::move(pages);
+		std::string executable = workerExecutable.string();
+		std::vector<char*> argv{executable.data(), const_cast<char*>(VSQtPdfManager::pageWorkerArgument.c_str())};
+		for(std::string& argument : arguments) {
+			argv.push_back(argument.data());
+		}
+		argv.push_back(nullptr);
+
+		int fds[2];
+		createPipe(fds);
+		posix_spawn_file_actions_t actions;
+		::posix_spawn_file_actions_init(&actions);
+		::posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+		pid_t pid = -1;
+		int err = ::posix_spawn(&pid, executable.c_str(), &actions, nullptr, argv.data(), environ);
+		::posix_spawn_file_actions_destroy(&actions);
+		::close(fds[1]);
+		if(err != 0)
+		{
+			::close(fds[0]);
+			throw std::runtime_error("Unable to start pdf worker process " + executable + ": " + std::strerror(err));
+		}
+		return {pid, fds[0]};
+	}
+
+	static void stop(Worker& worker)
+	{
+		if(worker.fd >= 0) {
+			::close(worker.fd);
+		}
+		if(worker.pid > 0) {
+			::kill(worker.pid, SIGKILL);
+			waitFor(worker.pid);
+		}
+		worker = Worker();
+	}
+
+	static bool write(int fd, const void* data, std::size_t size)
+	{
+		const char* bytes = static_cast<const char*>(data);
+		while(size > 0)
+		{
+			ssize_t written = ::write(fd, bytes, size);
+			if(written < 0 && errno == EINTR) {
+				continue;
+			}
+			if(written <= 0) {
+				return false;
+			}
+			bytes += written;
+			size -= static_cast<std::size_t>(written);
+		}
+		return true;
+	}
+
+	static void read(int fd, void* data, std::size_t size, const std::function<void()>& checkInterrupt)
+	{
+		char* bytes = static_cast<char*>(data);
+		while(size > 0)
+		{
+			pollfd pfd{fd, POLLIN, 0};
+			int ready = ::poll(&pfd, 1, 100);
+			checkInterrupt();
+			if(ready == 0 || (ready < 0 && errno == EINTR)) {
+				continue;
+			}
+			ssize_t received = ready > 0 ? ::read(fd, bytes, size) : -1;
+			if(received < 0 && errno == EINTR) {
+				continue;
+			}
+			if(received <= 0) {
+				throw std::runtime_error("Pdf worker process has terminated unexpectedly");
+			}
+			bytes += received;
+			size -= static_cast<std::size_t>(received);
+		}
+	}
+
+	static int waitFor(pid_t pid)
+	{
+		int status = 0;
+		while(::waitpid(pid, &status, 0) < 0 && errno == EINTR)
+		{}
+		return status;
+	}
+
+	tc::stdfs::path m_file;
+	std::vector<int> m_pages;
+	tc::file_as_img::ExportOptions m_options;
+	std::size_t m_workerCount = 0;
+	std::vector<Worker> m_workers;
+};
+
+#endif
+
+}
 
 VSQtPdfManager::VSQtPdfManager() :
 	tc::file_as_img::AbstractInterruptible<tc::file_as_img::fs::IExporter>(
@@ -18,7 +541,8 @@ VSQtPdfManager::VSQtPdfManager() :
 	),
 	tc::file_as_img::AbstractInterruptible<tc::file_as_img::mem::IThumbnailGenerator>(
 		std::make_unique<VSStdAtomicBoolInterruptor>()
-	)
+	),
+	m_bufferPool(std::make_shared<tc::file_as_img::mem::BufferPool>(tc::file_as_img::mem::BufferPool::defaultMaxIdleBytes))
 {}
 
 void VSQtPdfManager::exportAsImages(
@@ -29,8 +553,8 @@ void VSQtPdfManager::exportAsImages(
 {
 	using Interface = tc::file_as_img::IInterruptible<tc::file_as_img::mem::IExporter>;
 	validateArgsMem<Interface>(fileFormat, pixelFormat, options);
-	exportAsQImages<Interface>(file, options, [&](QImage& qimg) {
-		forEachImage(makeImage<Interface>(qimg, pixelFormat, options));
+	exportAsQImages<Interface>(file, options, [&](QImage& qimg, int page) {
+		forEachImage(makeImage<Interface>(qimg, pixelFormat, options, file, page));
 	});
 }
 
@@ -44,9 +568,43 @@ void VSQtPdfManager::exportAsImages(
 {
 	using Interface = tc::file_as_img::IInterruptible<tc::file_as_img::fs::IExporter>;
 	validateArgsFS<Interface>(fileFormat, imageFormat, options);
-	exportAsQImages<Interface>(file, options, [&](QImage& qimg) {
-		forEachImageName(save<Interface>(qimg, outputDir, imageFormat, imageNameGenerator, options));
+	ExportOptions exportOptions = tc::file_as_img::exportOptionsFrom(options);
+	if(exportOptions.bandHeight > 0 && tc::file_as_img::enc::isRowEncoded(imageFormat))
+	{
+		exportBanded<Interface>(file, outputDir, imageFormat, imageNameGenerator, exportOptions, forEachImageName);
+		return;
+	}
+	std::size_t pipelineDepth = exportOptions.pipelineDepth;
+	if(pipelineDepth == 0)
+	{
+		exportAsQImages<Interface>(file, options, [&](QImage& qimg, int page) {
+			forEachImageName(save<Interface>(qimg, outputDir, imageFormat, imageNameGenerator, options, file, page));
+		});
+		return;
+	}
+	using tc::file_as_img::Stage;
+	tc::file_as_img::IExportObserver* observer = exportOptions.observer.get();
+	tc::file_as_img::fs::ExportPipeline<RenderedPage, EncodedPage> pipeline(
+		pipelineDepth,
+		[&imageFormat, &exportOptions, &file, observer](RenderedPage& rendered) {
+			tc::file_as_img::StageTimer timer(observer, Stage::Encode, file, rendered.page);
+			EncodedPage encoded{encode(rendered.image, imageFormat, exportOptions), rendered.page};
+			timer.finish(0, encoded.bytes.size());
+			return encoded;
+		},
+		[&outputDir, &file, observer](const EncodedPage& encoded, const String& imgName) {
+			tc::file_as_img::StageTimer timer(observer, Stage::Write, file, encoded.page);
+			tc::file_as_img::fs::writeImageFile(outputDir / imgName, encoded.bytes.constData(), encoded.bytes.size());
+			timer.finish(0, encoded.bytes.size());
+		},
+		forEachImageName
+	);
+	exportAsQImages<Interface>(file, options, [&](QImage& qimg, int page) {
+		String imgName = imageNameGenerator();
+		Interface::checkInterrupt();
+		pipeline.push({qimg, page}, std::move(imgName));
 	});
+	pipeline.finish();
 }
 
 auto VSQtPdfManager::generateThumbnail(
@@ -56,8 +614,8 @@ auto VSQtPdfManager::generateThumbnail(
 	using Interface = tc::file_as_img::IInterruptible<tc::file_as_img::mem::IThumbnailGenerator>;
 	validateArgsMem<Interface>(fileFormat, pixelFormat, options);
 	std::unique_ptr<IImage> img;
-	exportAsQImages<Interface>(file, options, [&](QImage& qimg) {
-		img = makeImage<Interface>(qimg, pixelFormat, options);
+	exportAsQImages<Interface>(file, options, [&](QImage& qimg, int page) {
+		img = makeImage<Interface>(qimg, pixelFormat, options, file, page);
 	});
 	return img;
 }
@@ -72,12 +630,61 @@ auto VSQtPdfManager::generateThumbnail(
 	using Interface = tc::file_as_img::IInterruptible<tc::file_as_img::fs::IThumbnailGenerator>;
 	validateArgsFS<Interface>(fileFormat, imageFormat, options);
 	String imgName;
-	exportAsQImages<Interface>(file, options, [&](QImage& qimg) {
-		imgName = save<Interface>(qimg, outputDir, imageFormat, imageNameGenerator, options);
+	exportAsQImages<Interface>(file, options, [&](QImage& qimg, int page) {
+		imgName = save<Interface>(qimg, outputDir, imageFormat, imageNameGenerator, options, file, page);
 	});
 	return imgName;
 }
 
+void VSQtPdfManager::setDocumentCache(std::shared_ptr<tc::file_as_img::DocumentCache> cache)
+{
+	m_documentCache = std::move(cache);
+}
+
+void VSQtPdfManager::setBufferPool(std::shared_ptr<tc::file_as_img::mem::BufferPool> pool)
+{
+	m_bufferPool = std::move(pool);
+}
+
+std::string VSQtPdfManager::backendVersion()
+{
+	//Revision is incremented on changes of rendering which affect produced pixels.
+	return std::string("qtpdf-") + qVersion() + "-r2";
+}
+
+void VSQtPdfManager::flattenOver(QImage& image, std::uint32_t background)
+{
+	if(image.format() != QImage::Format_ARGB32 && image.format() != QImage::Format_ARGB32_Premultiplied) {
+		image.convertTo(QImage::Format_ARGB32_Premultiplied);
+	}
+	const tc::pixel::Kernels& kernels = tc::pixel::kernels();
+	bool premultiplied = image.format() == QImage::Format_ARGB32_Premultiplied;
+	for(int y = 0; y < image.height(); ++y)
+	{
+		auto* row = reinterpret_cast<std::uint32_t*>(image.scanLine(y));
+		if(!premultiplied) {
+			kernels.premultiply(row, image.width());
+		}
+		kernels.flattenOver(row, image.width(), background);
+	}
+	image.reinterpretAsFormat(QImage::Format_ARGB32);
+}
+
+void VSQtPdfManager::setWorkerExecutable(Path executable)
+{
+	workerExecutable = std::move(executable);
+}
+
+int VSQtPdfManager::runPageWorker(int argc, char** argv)
+{
+#ifdef VS_PDF_WORKER_PROCESSES
+	assert(argc >= 2 && argv[1] == pageWorkerArgument);
+	return PageWorkerProcesses::run(std::vector<std::string>(argv + 2, argv + argc), STDOUT_FILENO);
+#else
+	return 1;
+#endif
+}
+
 void VSQtPdfManager::validateFileFormat(const FileFormat& fileFormat) {
 	if(fileFormat != "pdf") {
 		throw tc::file_as_img::InvalidFileFormat();
@@ -87,7 +694,7 @@ void VSQtPdfManager::validateFileFormat(const FileFormat& fileFormat) {
 template<typename Interface>
 bool VSQtPdfManager::areOptionsValid(const Any& options)
 {
-	return !options.has_value() || static_cast<bool>(std::any_cast<DPI>(&options));
+	return tc::file_as_img::holdsExportOptions(options);
 }
 
 template<typename Interface>
@@ -118,47 +725,227 @@ void VSQtPdfManager::validateArgsMem(const FileFormat& fileFormat, const PixelFo
 	validateOptions<Interface>(options);
 }
 
+template<typename Interface>
+std::vector<int> VSQtPdfManager::pagesToExport(QPdfDocument& doc, const ExportOptions& options)
+{
+	constexpr bool thumbnail = tc::file_as_img::isThumbnailGenerator<Interface>;
+	int pageCount = pageCountOf(doc);
+	assert(pageCount >= 0);
+	Interface::checkInterrupt();
+	std::vector<int> pages = options.pages.resolve(pageCount);
+	if(thumbnail && pages.empty()) {
+		throw tc::file_as_img::NoDataAvailableForThumbnail();
+	}
+	if(thumbnail) {
+		pages.resize(1);
+	}
+	return pages;
+}
+
 template<typename Interface, typename F>
 void VSQtPdfManager::exportAsQImages(const Path& file, const Any& options, F forEachQImage)
 {
 	assert(areOptionsValid<Interface>(options));
 
 	constexpr bool thumbnail = tc::file_as_img::isThumbnailGenerator<Interface>;
-	QPdfDocument doc;
-	Interface::checkInterrupt();
-	QPdfDocument::DocumentError err = doc.load(QString::fromStdString(file.string()));
-	if(err != decltype(err)::NoError) {
-		throw std::runtime_error("QPdfDocument load error " + std::to_string(err));
-	}
-	Interface::checkInterrupt();
-	int pageCount = doc.pageCount();
-	assert(pageCount >= 0);
-	Interface::checkInterrupt();
-	if(thumbnail && pageCount < 1) {
-		throw tc::file_as_img::NoDataAvailableForThumbnail();
+	using tc::file_as_img::Stage;
+	using tc::file_as_img::CancellationToken;
+	ExportOptions exportOptions = tc::file_as_img::exportOptionsFrom(options);
+	CancellationToken documentToken = exportOptions.cancellation.withTimeout(exportOptions.timeouts.document);
+	auto checkInterrupt = [this, &documentToken] {
+		Interface::checkInterrupt();
+		documentToken.check();
+	};
+	//Page exceeding its budget is replaced by placeholder if options allow it, exceeded budget of document fails export.
+	auto isPlaceholderAllowed = [&exportOptions, &documentToken] {
+		return exportOptions.timeouts.placeholder && !documentToken.isExpired();
+	};
+
+	checkInterrupt();
+	tc::file_as_img::StageTimer loadTimer(exportOptions.observer.get(), Stage::Load, file);
+	tc::file_as_img::CachedDocument<std::shared_ptr<QPdfDocument>> doc(m_documentCache, file, "qtpdf", [&file] {
+		return std::shared_ptr<QPdfDocument>(loadPdfDocument(file));
+	});
+	loadTimer.finish();
+	checkInterrupt();
+	std::vector<int> pages = pagesToExport<Interface>(*doc.get(), exportOptions);
+	checkInterrupt();
+#ifdef VS_PDF_WORKER_PROCESSES
+	//Pages with budget are rendered by worker processes even if one worker is requested, so page exceeding budget
+	//is abandoned by killing its worker rather than awaited.
+	bool pageBudget = exportOptions.timeouts.page.count() > 0;
+	if(
+		PageWorkerProcesses::isAvailable() && !pages.empty() &&
+		(pageBudget || (!thumbnail && exportOptions.workers > 1 && pages.size() > 1))
+	)
+	{
+		PageWorkerProcesses workers;
+		workers.start(file, pages, exportOptions, std::clamp<std::size_t>(exportOptions.workers, 1, pages.size()));
+		for(std::size_t i = 0; i < pages.size(); ++i)
+		{
+			//Budget of page is counted from the moment it is awaited, its worker may have started it earlier.
+			CancellationToken pageToken = documentToken.withTimeout(exportOptions.timeouts.page);
+			tc::file_as_img::StageTimer renderTimer(exportOptions.observer.get(), Stage::Render, file, pages[i]);
+			PageWorkerProcesses::ReceivedPage received;
+			try
+			{
+				received = workers.receive(i, [this, &pageToken] {
+					Interface::checkInterrupt();
+					pageToken.check();
+				});
+			}
+			catch(const tc::err::exc::Timeout&)
+			{
+				if(!isPlaceholderAllowed()) {
+					throw;
+				}
+				workers.skip(i);
+				received = {placeholderOf(*doc.get(), pages[i], exportOptions), std::chrono::nanoseconds(0)};
+			}
+			QImage& img = received.image;
+			std::uint64_t pixels = std::uint64_t(img.width()) * img.height();
+			//Worker converts page just before sending it, so the convert stage ends when the page is received.
+			auto convertStart = renderTimer.finishBefore(received.convertDuration, pixels);
+			if(exportOptions.observer && received.convertDuration.count() > 0)
+			{
+				exportOptions.observer->onStage({
+					Stage::Convert, file, pages[i], convertStart, tc::file_as_img::StageEvent::Clock::now(),
+					std::this_thread::get_id(), pixels, 0
+				});
+			}
+			checkInterrupt();
+			forEachQImage(img, pages[i]);
+			checkInterrupt();
+		}
+		workers.join();
+		return;
 	}
-	DPI dpi = options.has_value() ? std::any_cast<DPI>(options) : 96.0;
-	Interface::checkInterrupt();
-	for(int i = 0; i < (thumbnail ? 1 : pageCount); ++i)
+#endif
+	for(int page : pages)
 	{
-		QSizeF pageSize = doc.pageSize(i);
-		Interface::checkInterrupt();
-		QImage rendered = doc.render(
-			i,
-			QSize(tc::pointsToPixels(pageSize.width(), dpi), tc::pointsToPixels(pageSize.height(), dpi))
-		);
-		if(rendered.isNull()) {
-			throw std::runtime_error("Unable to render pdf page");
-		}
-		QImage img(rendered.size(), rendered.format());
-		img.fill(Qt::white);
-		QPainter p(&img);
-		p.setCompositionMode(QPainter::CompositionMode_SourceAtop);
-		p.drawImage(0, 0, rendered);
-		assert(!img.isNull());
-		Interface::checkInterrupt();
-		forEachQImage(img);
+		CancellationToken pageToken = documentToken.withTimeout(exportOptions.timeouts.page);
+		QImage img = renderPage(*doc.get(), page, exportOptions, file);
+		//Rendering by pdfium can not be interrupted, so page budget is checked once page is rendered.
+		try {
+			pageToken.check();
+		}
+		catch(const tc::err::exc::Timeout&)
+		{
+			if(!isPlaceholderAllowed()) {
+				throw;
+			}
+			img = placeholderOf(*doc.get(), page, exportOptions);
+		}
+		checkInterrupt();
+		forEachQImage(img, page);
+		checkInterrupt();
+	}
+}
+
+template<typename Interface>
+void VSQtPdfManager::exportBanded(
+	const Path& file, const Path& outputDir, const ImageFormat& imageFormat,
+	const AnyImageNameGenerator& imageNameGenerator, const ExportOptions& options,
+	const AnyImageNameConsumer& forEachImageName
+)
+{
+	assert(options.bandHeight > 0);
+	assert(tc::file_as_img::enc::isRowEncoded(imageFormat));
+
+	using tc::file_as_img::Stage;
+	using tc::file_as_img::CancellationToken;
+	CancellationToken documentToken = options.cancellation.withTimeout(options.timeouts.document);
+	auto checkInterrupt = [this, &documentToken] {
 		Interface::checkInterrupt();
+		documentToken.check();
+	};
+
+	checkInterrupt();
+	tc::file_as_img::StageTimer loadTimer(options.observer.get(), Stage::Load, file);
+	tc::file_as_img::CachedDocument<std::shared_ptr<QPdfDocument>> doc(m_documentCache, file, "qtpdf", [&file] {
+		return std::shared_ptr<QPdfDocument>(loadPdfDocument(file));
+	});
+	loadTimer.finish();
+	checkInterrupt();
+	std::vector<int> pages = pagesToExport<Interface>(*doc.get(), options);
+	for(int page : pages)
+	{
+		String imgName = imageNameGenerator();
+		Path imgPath = outputDir / imgName;
+		checkInterrupt();
+		QSize size = pixelSizeOf(*doc.get(), page, options);
+		int bandHeight = static_cast<int>(std::min<std::size_t>(options.bandHeight, size.height()));
+		//Writes image of bands returned by bandAt(top, rowCount), which hold at least rowCount rows.
+		auto writeImage = [&](const std::function<QImage(int, int)>& bandAt) {
+			//Existing file is unlinked rather than truncated as by writeImageFile.
+			std::error_code err;
+			tc::stdfs::remove(imgPath, err);
+			std::ofstream imgFile(imgPath, std::ios::binary | std::ios::trunc);
+			//Encoded bytes are written to file as encoder produces them, so encode stages include writing.
+			std::uint64_t written = 0;
+			try
+			{
+				auto encoder = tc::file_as_img::enc::makeRowEncoder(
+					size.width(), size.height(), false, imageFormat, options,
+					[&imgFile, &imgPath, &written](const std::uint8_t* data, std::size_t count) {
+						imgFile.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count));
+						if(!imgFile) {
+							throw std::runtime_error("Unable to write image file " + imgPath.string());
+						}
+						written += count;
+					}
+				);
+				for(int top = 0; top < size.height(); top += bandHeight)
+				{
+					int rowCount = std::min(bandHeight, size.height() - top);
+					QImage band = bandAt(top, rowCount);
+					checkInterrupt();
+					std::uint64_t writtenBefore = written;
+					tc::file_as_img::StageTimer encodeTimer(options.observer.get(), Stage::Encode, file, page);
+					encoder->writeRows(band.constBits(), rowCount, band.bytesPerLine());
+					encodeTimer.finish(0, written - writtenBefore);
+					checkInterrupt();
+				}
+				std::uint64_t writtenBefore = written;
+				tc::file_as_img::StageTimer encodeTimer(options.observer.get(), Stage::Encode, file, page);
+				encoder->finish();
+				encodeTimer.finish(0, written - writtenBefore);
+				imgFile.close();
+				if(!imgFile) {
+					throw std::runtime_error("Unable to write image file " + imgPath.string());
+				}
+			}
+			catch(...)
+			{
+				//Incomplete image is not left behind.
+				imgFile.close();
+				tc::stdfs::remove(imgPath, err);
+				throw;
+			}
+		};
+		//Rendering of band can not be interrupted, so page budget is checked between bands.
+		CancellationToken pageToken = documentToken.withTimeout(options.timeouts.page);
+		try
+		{
+			writeImage([&](int top, int rowCount) {
+				QImage band = renderBand(*doc.get(), page, options, file, size, top, rowCount);
+				pageToken.check();
+				return band;
+			});
+		}
+		catch(const tc::err::exc::Timeout&)
+		{
+			if(!options.timeouts.placeholder || documentToken.isExpired()) {
+				throw;
+			}
+			//Page is written again as placeholder, all its bands are the same band of background colour.
+			QImage band(size.width(), bandHeight, QImage::Format_ARGB32);
+			band.fill(0xFF000000u | options.render.background);
+			writeImage([&band](int, int) {
+				return band;
+			});
+		}
+		forEachImageName(imgName);
 	}
 }
 
@@ -167,33 +954,72 @@ auto VSQtPdfManager::save(
 	QImage& image,
 	const Path& outputDir, const ImageFormat& imageFormat,
 	const AnyImageNameGenerator& imageNameGenerator,
-	const Any& options
+	const Any& options, const Path& file, int page
 ) -> String
 {
 	assert(supportedImageFormats.count(imageFormat));
 	assert(areOptionsValid<Interface>(options));
 	assert(!image.isNull());
 
+	using tc::file_as_img::Stage;
+	ExportOptions exportOptions = tc::file_as_img::exportOptionsFrom(options);
 	String imgName = imageNameGenerator();
 	Interface::checkInterrupt();
-	bool saved = image.save(QString::fromStdString((outputDir / imgName).string()));
-	if(!saved) {
-		throw std::runtime_error("Unable to save QImage");
-	}
+	tc::file_as_img::StageTimer encodeTimer(exportOptions.observer.get(), Stage::Encode, file, page);
+	QByteArray bytes = encode(image, imageFormat, exportOptions);
+	encodeTimer.finish(0, bytes.size());
+	Interface::checkInterrupt();
+	tc::file_as_img::StageTimer writeTimer(exportOptions.observer.get(), Stage::Write, file, page);
+	tc::file_as_img::fs::writeImageFile(outputDir / imgName, bytes.constData(), bytes.size());
+	writeTimer.finish(0, bytes.size());
 	return imgName;
 }
 
+QByteArray VSQtPdfManager::encode(const QImage& image, const ImageFormat& imageFormat, const ExportOptions& options)
+{
+	assert(supportedImageFormats.count(imageFormat));
+	assert(!image.isNull());
+
+	QByteArray bytes;
+	auto append = [&bytes](const std::uint8_t* data, std::size_t size) {
+		bytes.append(reinterpret_cast<const char*>(data), static_cast<int>(size));
+	};
+	if(image.format() == QImage::Format_ARGB32 && tc::file_as_img::enc::isEncoded(imageFormat))
+	{
+		//Rendered pages are flattened over white, so alpha channel is dropped.
+		tc::file_as_img::enc::encode(
+			image.constBits(), image.width(), image.height(), image.bytesPerLine(), false, imageFormat, options, append
+		);
+		return bytes;
+	}
+	QBuffer buffer(&bytes);
+	buffer.open(QIODevice::WriteOnly);
+	if(!image.save(&buffer, imageFormat.c_str())) {
+		throw std::runtime_error("Unable to encode QImage");
+	}
+	return bytes;
+}
+
 template<typename Interface>
 auto VSQtPdfManager::makeImage(
-	QImage& image, const PixelFormat& pixelFormat, const Any& options
+	QImage& image, const PixelFormat& pixelFormat, const Any& options, const Path& file, int page
 ) -> std::unique_ptr<IImage>
 {
 	assert(supportedPixelFormats.left.count(pixelFormat));
 	assert(areOptionsValid<Interface>(options));
 	assert(!image.isNull());
 
-	image.convertTo(supportedPixelFormats.left.at(pixelFormat));
-	return std::make_unique<Image>(image);
+	tc::file_as_img::StageTimer timer(
+		tc::file_as_img::exportOptionsFrom(options).observer.get(), tc::file_as_img::Stage::Convert, file, page
+	);
+	convertPixels(image, supportedPixelFormats.left.at(pixelFormat), m_bufferPool.get());
+	timer.finish(std::uint64_t(image.width()) * image.height());
+	//Deleter holds implicitly shared copy of image, so its pixels are handed out without copying.
+	return std::make_unique<tc::file_as_img::mem::Image>(
+		reinterpret_cast<const IImage::Byte*>(image.constBits()),
+		[image](const IImage::Byte*) {},
+		image.width(), image.height(), image.bytesPerLine(), pixelFormat
+	);
 //	assert(!image.isNull());
 //	size_t size = image.sizeInBytes();
 //	assert(size > 0);
@@ -1,15 +1,24 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <unordered_set>
+#include <vector>
 
 #include <boost/bimap.hpp>
 #include <boost/bimap/unordered_set_of.hpp>
 #include <boost/assign.hpp>
 
+#include <QByteArray>
 #include <QImage>
 
+class QPdfDocument;
+
 #include "VSExportFileAsImages.h"
+#include "VSExportOptions.h"
+#include "VSDocumentCache.h"
+#include "VSBufferPool.h"
 
 class VSQtPdfManager :
 	public tc::file_as_img::AbstractInterruptible<tc::file_as_img::fs::IExporter>,
@@ -29,42 +38,18 @@ public:
 	inline static const std::unordered_set<ImageFormat> supportedImageFormats = {
 		"png",
 		"jpg",
-		"jpeg"
+		"jpeg",
+		"webp"
 	};
 
 	inline static const bimap<PixelFormat, QImage::Format> supportedPixelFormats =
 		boost::assign::list_of<bimap<PixelFormat, QImage::Format>::relation>
-		("argb32", QImage::Format_ARGB32);
-
-	using DPI = double;
-
-	class Image : public IImage
-	{
-	public:
-		Image(QImage img) : img(img)
-		{
-			assert(!img.isNull());
-			assert(img.width() > 0);
-			assert(img.height() > 0);
-			assert(supportedPixelFormats.right.count(img.format()));
-		}
-
-		Size width() const override {
-			return img.width();
-		}
-		Size height() const override {
-			return img.height();
-		}
-		PixelFormat format() const override {
-			return supportedPixelFormats.right.at(img.format());
-		}
-		const Byte* data() const override {
-			return reinterpret_cast<const Byte*>(img.constBits());
-		}
-
-	private:
-		QImage img;
-	};
+		("argb32", QImage::Format_ARGB32)
+		("rgba8888", QImage::Format_RGBA8888)
+		("rgb888", QImage::Format_RGB888);
+
+	using ExportOptions = tc::file_as_img::ExportOptions;
+	using DPI = ExportOptions::DPI;
 
 	VSQtPdfManager();
 
@@ -93,6 +78,34 @@ public:
 		const Any& options
 	) override;
 
+	///@brief Enables reuse of loaded documents across calls by @p cache, which may be shared with other backends,
+	/// nullptr disables it. Not thread safe relative to exports.
+	void setDocumentCache(std::shared_ptr<tc::file_as_img::DocumentCache> cache);
+	///@brief Draws pixel buffers of in-memory images from @p pool, which may be shared with other backends,
+	/// nullptr disables pooling. Every instance starts with its own pool. Not thread safe relative to exports.
+	void setBufferPool(std::shared_ptr<tc::file_as_img::mem::BufferPool> pool);
+	const std::shared_ptr<tc::file_as_img::mem::BufferPool>& bufferPool() const {
+		return m_bufferPool;
+	}
+
+	///@brief Identifies rendering code and library version, images rendered by different versions may differ.
+	static std::string backendVersion();
+
+	///@brief Composites @p image over @p background 0xRRGGBB colour in place and marks it as opaque Format_ARGB32,
+	/// so no second full-frame buffer is needed. Straight alpha of Format_ARGB32 pages rendered by QPdfDocument is
+	/// premultiplied row by row just before flattening while the row is in cache.
+	static void flattenOver(QImage& image, std::uint32_t background);
+
+	///@brief First argument of executable which makes it run runPageWorker() instead of its usual work.
+	inline static const std::string pageWorkerArgument = "--pdf-page-worker";
+	///@brief Renders pages in parallel, or with budget, by worker processes started as @p executable with
+	/// pageWorkerArgument. Without it all pages are rendered by calling thread. Not thread safe relative to exports.
+	static void setWorkerExecutable(Path executable);
+	///@brief Renders pages requested by arguments of worker process started by exporter to standard output.
+	///@pre argv[1] is pageWorkerArgument.
+	///@return exit status of worker process.
+	static int runPageWorker(int argc, char** argv);
+
 private:
 	static void validateFileFormat(const FileFormat& fileFormat);
 	template<typename Interface>
@@ -104,18 +117,41 @@ private:
 	template<typename Interface>
 	static void validateArgsMem(const FileFormat& fileFormat, const PixelFormat& pixelFormat, const Any& options);
 
+	///@return pages of @p doc selected by @p options, only the first one for thumbnails.
+	template<typename Interface>
+	static std::vector<int> pagesToExport(QPdfDocument& doc, const ExportOptions& options);
+
+	///@brief Invokes @p forEachQImage with every rendered page and its index.
 	template<typename Interface, typename F>
 	void exportAsQImages(const Path& file, const Any& options, F forEachQImage);
 
+	///@brief Renders pages in bands of options.bandHeight rows, which are encoded to files as they are rendered.
+	/// Pages are rendered sequentially regardless of workers.
+	template<typename Interface>
+	void exportBanded(
+		const Path& file, const Path& outputDir, const ImageFormat& imageFormat,
+		const AnyImageNameGenerator& imageNameGenerator, const ExportOptions& options,
+		const AnyImageNameConsumer& forEachImageName
+	);
+
+	static QByteArray encode(const QImage& image, const ImageFormat& imageFormat, const ExportOptions& options);
+
+	///@param file and @p page are reported to observer of @p options.
 	template<typename Interface>
 	String save(
 		QImage& image,
 		const Path& outputDir, const ImageFormat& imageFormat,
 		const AnyImageNameGenerator& imageNameGenerator,
-		const Any& options
+		const Any& options, const Path& file, int page
 	);
 
+	///@param file and @p page are reported to observer of @p options.
 	template<typename Interface>
-	std::unique_ptr<IImage> makeImage(QImage& image, const PixelFormat& pixelFormat, const Any& options);
+	std::unique_ptr<IImage> makeImage(
+		QImage& image, const PixelFormat& pixelFormat, const Any& options, const Path& file, int page
+	);
+
+	std::shared_ptr<tc::file_as_img::DocumentCache> m_documentCache;
+	std::shared_ptr<tc::file_as_img::mem::BufferPool> m_bufferPool;
 
 };
\ No newline at end of file
@@ -0,0 +1,331 @@
+#include "VSRenderCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+#include "VSSha256.h"
+
+namespace tc::file_as_img::fs
+{
+
+namespace
+{
+
+///@return unique sibling of @p target to be renamed to it once complete.
+tc::stdfs::path temporaryOf(const tc::stdfs::path& target)
+{
+	static std::atomic<std::size_t> counter = 0;
+	return target.string() + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) +
+		"-" + std::to_string(counter++);
+}
+
+}
+
+RenderCache::RenderCache(Path directory, std::uintmax_t sizeLimit) :
+	m_directory(std::move(directory)), m_sizeLimit(sizeLimit)
+{
+	tc::stdfs::create_directories(m_directory);
+	rescan();
+}
+
+auto RenderCache::entryOf(
+	const Path& file, const FileFormat& fileFormat, const ImageFormat& imageFormat,
+	const ExportOptions& options, const std::string& backendVersion
+) const -> Path
+{
+	Sha256 key;
+	key.update(Sha256::toHex(Sha256::ofFile(file))).update("\n")
+		.update(fileFormat).update("\n")
+		.update(imageFormat).update("\n")
+		.update(boost::lexical_cast<std::string>(options.dpi)).update("\n");
+	if(!options.fitWithin.empty()) {
+		key.update(std::to_string(options.fitWithin.width) + "x" + std::to_string(options.fitWithin.height)).update("\n");
+	}
+	if(!options.render.isDefault())
+	{
+		key.update(options.render.antialiasing ? "aa" : "aliased").update(",")
+			.update(options.render.textHinting ? "hinted" : "unhinted").update(",")
+			.update(std::to_string(options.render.background)).update("\n");
+	}
+	if(imageFormat == "png")
+	{
+		key.update(std::to_string(options.png.compressionLevel)).update(",")
+			.update(std::to_string(static_cast<int>(options.png.filter))).update(",")
+			.update(std::to_string(static_cast<int>(options.png.strategy))).update("\n");
+	}
+	if(imageFormat == "jpg" || imageFormat == "jpeg")
+	{
+		key.update(std::to_string(options.jpeg.quality)).update(",")
+			.update(std::to_string(static_cast<int>(options.jpeg.subsampling))).update(",")
+			.update(options.jpeg.progressive ? "progressive" : "baseline").update("\n");
+	}
+	if(imageFormat == "webp")
+	{
+		key.update(options.webp.lossless ? "lossless" : "lossy").update(",")
+			.update(boost::lexical_cast<std::string>(options.webp.quality)).update(",")
+			.update(std::to_string(options.webp.method)).update("\n");
+	}
+	key.update(backendVersion);
+	return m_directory / Sha256::toHex(key.finish());
+}
+
+auto RenderCache::imageOf(const Path& entry, std::size_t page, const ImageFormat& imageFormat) -> Path
+{
+	return entry / (std::to_string(page) + "." + imageFormat);
+}
+
+std::optional<int> RenderCache::pageCountOf(const Path& entry) const
+{
+	std::ifstream stream(entry / "pageCount");
+	int pageCount = -1;
+	if(stream >> pageCount && pageCount >= 0) {
+		return pageCount;
+	}
+	return std::nullopt;
+}
+
+void RenderCache::setPageCount(const Path& entry, int pageCount)
+{
+	std::error_code err;
+	tc::stdfs::create_directories(entry, err);
+	Path temporary = temporaryOf(entry / "pageCount");
+	{
+		std::ofstream stream(temporary, std::ios::trunc);
+		stream << pageCount;
+	}
+	tc::stdfs::rename(temporary, entry / "pageCount", err);
+	if(err) {
+		tc::stdfs::remove(temporary, err);
+	}
+}
+
+auto RenderCache::cachedPagesOf(
+	const Path& entry, const PageSet& pages, const ImageFormat& imageFormat
+) const -> std::optional<std::vector<int>>
+{
+	if(pages.selectsAll()) {
+		return std::nullopt;
+	}
+	std::vector<int> cached;
+	std::error_code err;
+	for(std::size_t n = 0, page = pages.nth(0); page != std::numeric_limits<std::size_t>::max(); page = pages.nth(++n))
+	{
+		if(page > static_cast<std::size_t>(std::numeric_limits<int>::max()) ||
+			!tc::stdfs::is_regular_file(imageOf(entry, page, imageFormat), err))
+		{
+			return std::nullopt;
+		}
+		cached.push_back(static_cast<int>(page));
+	}
+	return cached;
+}
+
+bool RenderCache::load(const Path& image, const Path& target)
+{
+	return place(image, target);
+}
+
+void RenderCache::store(const Path& source, const Path& image)
+{
+	std::error_code err;
+	tc::stdfs::create_directories(image.parent_path(), err);
+	place(source, image);
+}
+
+void RenderCache::commit(const Path& entry)
+{
+	std::error_code err;
+	auto now = tc::stdfs::file_time_type::clock::now();
+	tc::stdfs::last_write_time(entry, now, err);
+	std::uintmax_t size = sizeOf(entry);
+	std::lock_guard lock(m_indexMutex);
+	IndexEntry& indexed = m_index[entry];
+	m_indexedSize = m_indexedSize - indexed.size + size;
+	indexed = {now, size};
+	if(m_indexedSize > m_sizeLimit) {
+		evict();
+	}
+}
+
+bool RenderCache::place(const Path& source, const Path& target)
+{
+	std::error_code err;
+	Path temporary = temporaryOf(target);
+	tc::stdfs::create_hard_link(source, temporary, err);
+	if(err)
+	{
+		err.clear();
+		tc::stdfs::copy_file(source, temporary, tc::stdfs::copy_options::overwrite_existing, err);
+	}
+	if(!err) {
+		tc::stdfs::rename(temporary, target, err);
+	}
+	if(err)
+	{
+		std::error_code ignored;
+		tc::stdfs::remove(temporary, ignored);
+		return false;
+	}
+	return true;
+}
+
+std::uintmax_t RenderCache::sizeOf(const Path& entry)
+{
+	std::error_code err;
+	std::uintmax_t size = 0;
+	for(const auto& image : tc::stdfs::directory_iterator(entry, err))
+	{
+		std::uintmax_t imageSize = image.file_size(err);
+		if(!err) {
+			size += imageSize;
+		}
+	}
+	return size;
+}
+
+void RenderCache::rescan()
+{
+	std::error_code err;
+	m_index.clear();
+	m_indexedSize = 0;
+	for(const auto& directory : tc::stdfs::directory_iterator(m_directory, err))
+	{
+		if(!directory.is_directory(err)) {
+			continue;
+		}
+		IndexEntry entry{tc::stdfs::last_write_time(directory.path(), err), sizeOf(directory.path())};
+		m_indexedSize += entry.size;
+		m_index.emplace(directory.path(), entry);
+	}
+}
+
+void RenderCache::evict()
+{
+	rescan();
+	if(m_indexedSize <= m_sizeLimit) {
+		return;
+	}
+	const std::uintmax_t lowWaterMark = m_sizeLimit - m_sizeLimit / 10;
+	std::vector<std::map<Path, IndexEntry>::const_iterator> entries;
+	entries.reserve(m_index.size());
+	for(auto entry = m_index.cbegin(); entry != m_index.cend(); ++entry) {
+		entries.push_back(entry);
+	}
+	std::sort(entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs) {
+		return lhs->second.lastUse < rhs->second.lastUse;
+	});
+	std::error_code err;
+	for(auto entry = entries.begin(); m_indexedSize > lowWaterMark && entry != entries.end(); ++entry)
+	{
+		tc::stdfs::remove_all((*entry)->first, err);
+		m_indexedSize -= (*entry)->second.size;
+		m_index.erase(*entry);
+	}
+}
+
+CachingExporter::CachingExporter(Exporter& exporter, std::string backendVersion, std::shared_ptr<RenderCache> cache) :
+	m_exporter(exporter), m_backendVersion(std::move(backendVersion)), m_cache(std::move(cache))
+{
+	assert(m_cache);
+}
+
+void CachingExporter::exportAsImages(
+	const Path& file, const FileFormat& fileFormat,
+	const Path& outputDir, const ImageFormat& imageFormat,
+	const AnyImageNameGenerator& imageNameGenerator,
+	const Any& options,
+	const AnyImageNameConsumer& forEachImageName
+)
+{
+	//Placeholders of pages exceeding their budgets must not be served as rendered pages later.
+	if(!holdsExportOptions(options) || exportOptionsFrom(options).timeouts.placeholder) {
+		m_exporter.exportAsImages(file, fileFormat, outputDir, imageFormat, imageNameGenerator, options, forEachImageName);
+		return;
+	}
+	ExportOptions exportOptions = exportOptionsFrom(options);
+	Path entry = m_cache->entryOf(file, fileFormat, imageFormat, exportOptions, m_backendVersion);
+	std::optional<int> pageCount = m_cache->pageCountOf(entry);
+	//Without page count pages are served from cache only if images of all of them are there, which proves they exist.
+	std::optional<std::vector<int>> selected = pageCount ?
+		exportOptions.pages.resolve(*pageCount) : m_cache->cachedPagesOf(entry, exportOptions.pages, imageFormat);
+	if(!selected)
+	{
+		//Pages are produced in ascending order of selected pages, so n-th image is nth() page.
+		std::size_t produced = 0;
+		m_exporter.exportAsImages(
+			file, fileFormat, outputDir, imageFormat, imageNameGenerator, options,
+			[&](const String& imageName) {
+				m_cache->store(
+					outputDir / imageName, RenderCache::imageOf(entry, exportOptions.pages.nth(produced++), imageFormat)
+				);
+				forEachImageName(imageName);
+			}
+		);
+		if(exportOptions.pages.selectsAll()) {
+			m_cache->setPageCount(entry, static_cast<int>(produced));
+		}
+		m_cache->commit(entry);
+		return;
+	}
+
+	const std::vector<int>& pages = *selected;
+	std::vector<String> imageNames;
+	std::vector<bool> cached;
+	std::vector<std::size_t> missing;
+	ExportOptions missingOptions = exportOptions;
+	missingOptions.pages = PageSet();
+	for(std::size_t i = 0; i < pages.size(); ++i)
+	{
+		checkInterrupt();
+		exportOptions.cancellation.check();
+		imageNames.push_back(imageNameGenerator());
+		cached.push_back(m_cache->load(RenderCache::imageOf(entry, pages[i], imageFormat), outputDir / imageNames[i]));
+		if(!cached[i])
+		{
+			missing.push_back(i);
+			missingOptions.pages.add(static_cast<std::size_t>(pages[i]));
+		}
+	}
+
+	std::size_t reported = 0;
+	auto reportCachedUntil = [&](std::size_t end) {
+		for(; reported < end; ++reported)
+		{
+			if(cached[reported]) {
+				forEachImageName(imageNames[reported]);
+			}
+		}
+	};
+	if(!missing.empty())
+	{
+		std::size_t generated = 0;
+		std::size_t produced = 0;
+		m_exporter.exportAsImages(
+			file, fileFormat, outputDir, imageFormat,
+			[&] {
+				return imageNames[missing.at(generated++)];
+			},
+			missingOptions,
+			[&](const String& imageName) {
+				std::size_t i = missing.at(produced++);
+				reportCachedUntil(i);
+				m_cache->store(outputDir / imageName, RenderCache::imageOf(entry, pages[i], imageFormat));
+				forEachImageName(imageName);
+				reported = i + 1;
+			}
+		);
+	}
+	reportCachedUntil(pages.size());
+	m_cache->commit(entry);
+}
+
+} //namespace tc::file_as_img::fs
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "VSExportFileAsImages.h"
+#include "VSExportOptions.h"
+
+namespace tc::file_as_img::fs
+{
+
+///@brief Persistent content addressed store of rendered images shared by CachingExporter instances.
+///
+/// Every entry is a directory named by SHA-256 of input file content, file and image formats, DPI, encoder settings
+/// and backend version, so byte identical files share images regardless of their paths. Entry holds images named <page>.<imageFormat> and
+/// page count of document once it is known. Image also proves its page exists, so ranges of pages are served from
+/// images of earlier exports before page count is known. Total size of directory is capped, least recently used entries are
+/// evicted first. Several processes may share one directory, files are published by atomic renames.
+///
+/// Sizes and last uses of entries are indexed once on construction and updated on commits, directory is rescanned
+/// only when indexed size exceeds the limit, and then entries are evicted down to 90% of it, so rescans are amortised
+/// over at least a tenth of the limit of stored images.
+class RenderCache : public TypesHolder
+{
+public:
+	RenderCache(Path directory, std::uintmax_t sizeLimit);
+	RenderCache(const RenderCache&) = delete;
+	RenderCache& operator=(const RenderCache&) = delete;
+
+	///@throw std::runtime_error if @p file can not be read.
+	Path entryOf(
+		const Path& file, const FileFormat& fileFormat, const ImageFormat& imageFormat,
+		const ExportOptions& options, const std::string& backendVersion
+	) const;
+	static Path imageOf(const Path& entry, std::size_t page, const ImageFormat& imageFormat);
+
+	std::optional<int> pageCountOf(const Path& entry) const;
+	void setPageCount(const Path& entry, int pageCount);
+	///@return pages selected by @p pages if images of all of them are in @p entry, which proves they exist
+	/// in document of unknown page count, std::nullopt otherwise or if @p pages selects all pages.
+	std::optional<std::vector<int>> cachedPagesOf(
+		const Path& entry, const PageSet& pages, const ImageFormat& imageFormat
+	) const;
+
+	///@brief Places cached image to @p target by hard link or copy.
+	///@return false if image is not cached.
+	bool load(const Path& image, const Path& target);
+	///@brief Stores copy of @p source as @p image, failures are ignored as cache is optional.
+	void store(const Path& source, const Path& image);
+	///@brief Marks @p entry as recently used and evicts least recently used entries exceeding size limit.
+	void commit(const Path& entry);
+
+private:
+	///@brief Atomically replaces @p target by hard link to or copy of @p source.
+	static bool place(const Path& source, const Path& target);
+	struct IndexEntry
+	{
+		tc::stdfs::file_time_type lastUse;
+		std::uintmax_t size = 0;
+	};
+
+	static std::uintmax_t sizeOf(const Path& entry);
+	///@brief Replaces index by entries found in directory, which may have been changed by other processes.
+	void rescan();
+	void evict();
+
+	Path m_directory;
+	std::uintmax_t m_sizeLimit;
+	std::mutex m_indexMutex;
+	std::map<Path, IndexEntry> m_index;
+	std::uintmax_t m_indexedSize = 0;
+};
+
+///@brief Serves pages from RenderCache and renders only missing pages by wrapped exporter.
+///
+/// Produced images share storage with the cache when hard links are supported, so they must not be modified in place.
+/// Options other than ExportOptions or DPI, and options allowing placeholders of pages, are passed to exporter as is
+/// and bypass the cache.
+class CachingExporter : public IInterruptible<IExporter>
+{
+public:
+	using Exporter = IInterruptible<IExporter>;
+
+	CachingExporter(Exporter& exporter, std::string backendVersion, std::shared_ptr<RenderCache> cache);
+
+	bool isInterruptSetFor(TaskOf<IExporter>) const override {
+		return m_exporter.isInterruptSetFor(taskOf<IExporter>);
+	}
+	void setInterruptFor(TaskOf<IExporter>, bool interrupt) override {
+		m_exporter.setInterruptFor(taskOf<IExporter>, interrupt);
+	}
+
+	void exportAsImages(
+		const Path& file, const FileFormat& fileFormat,
+		const Path& outputDir, const ImageFormat& imageFormat,
+		const AnyImageNameGenerator& imageNameGenerator,
+		const Any& options,
+		const AnyImageNameConsumer& forEachImageName
+	) override;
+
+private:
+	Exporter& m_exporter;
+	std::string m_backendVersion;
+	std::shared_ptr<RenderCache> m_cache;
+};
+
+} //namespace tc::file_as_img::fs
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "VSRenderCache.h"
+
+//Checks that CachingExporter serves ranges of pages from images of earlier exports before page count is known, and
+//renders only pages missing from cache. Exporter renders fake document, exit status is number of failed checks.
+
+namespace
+{
+
+using namespace tc::file_as_img;
+using tc::file_as_img::fs::CachingExporter;
+using tc::file_as_img::fs::RenderCache;
+using Path = TypesHolder::Path;
+using String = fs::TypesHolder::String;
+
+int failures = 0;
+
+void expect(bool condition, const std::string& what)
+{
+	if(!condition)
+	{
+		++failures;
+		std::cerr << "FAILED " << what << std::endl;
+	}
+}
+
+///@brief Exports document of pageCount pages as images holding their page numbers and counts rendered pages.
+class FakeExporter : public IInterruptible<fs::IExporter>
+{
+public:
+	static constexpr int pageCount = 10;
+
+	bool isInterruptSetFor(TaskOf<fs::IExporter>) const override {
+		return m_interrupt.isInterruptSet();
+	}
+	void setInterruptFor(TaskOf<fs::IExporter>, bool interrupt) override {
+		m_interrupt.setInterrupt(interrupt);
+	}
+
+	void exportAsImages(
+		const Path&, const FileFormat&,
+		const Path& outputDir, const ImageFormat&,
+		const AnyImageNameGenerator& imageNameGenerator,
+		const Any& options,
+		const AnyImageNameConsumer& forEachImageName
+	) override
+	{
+		for(int page : exportOptionsFrom(options).pages.resolve(pageCount))
+		{
+			String imageName = imageNameGenerator();
+			std::ofstream(outputDir / imageName) << page;
+			++rendered;
+			forEachImageName(imageName);
+		}
+	}
+
+	int rendered = 0;
+
+private:
+	VSStdAtomicBoolInterruptor m_interrupt;
+};
+
+struct Export
+{
+	int rendered = 0;
+	std::vector<int> pages;
+};
+
+Export exportPages(CachingExporter& exporter, FakeExporter& fake, const Path& file, const Path& outputDir, PageSet pages)
+{
+	tc::stdfs::remove_all(outputDir);
+	tc::stdfs::create_directories(outputDir);
+	ExportOptions options;
+	options.pages = std::move(pages);
+	int renderedBefore = fake.rendered;
+	Export result;
+	exporter.exportAsImages(
+		file, "fake", outputDir, "txt", fs::IncrementNameGenerator(0, ".txt"), options,
+		[&](const String& imageName) {
+			std::ifstream image(outputDir / imageName);
+			int page = -1;
+			image >> page;
+			result.pages.push_back(page);
+		}
+	);
+	result.rendered = fake.rendered - renderedBefore;
+	return result;
+}
+
+}
+
+int main()
+{
+	Path root = tc::stdfs::temp_directory_path() / "fileAsImg_render_cache_test";
+	tc::stdfs::remove_all(root);
+	tc::stdfs::create_directories(root);
+	Path file = root / "document.fake";
+	std::ofstream(file) << "fake document";
+	Path outputDir = root / "output";
+
+	FakeExporter fake;
+	CachingExporter exporter(fake, "fake-1", std::make_shared<RenderCache>(root / "cache", 1 << 20));
+
+	Export first = exportPages(exporter, fake, file, outputDir, PageSet::parse("2-4"));
+	expect(first.rendered == 3 && first.pages == std::vector<int>{2, 3, 4}, "range is rendered on miss");
+	Export repeated = exportPages(exporter, fake, file, outputDir, PageSet::parse("2-4"));
+	expect(repeated.rendered == 0 && repeated.pages == first.pages, "repeated range is served from cache");
+	Export subset = exportPages(exporter, fake, file, outputDir, PageSet::parse("3"));
+	expect(subset.rendered == 0 && subset.pages == std::vector<int>{3}, "subset of range is served from cache");
+	Export wider = exportPages(exporter, fake, file, outputDir, PageSet::parse("3-5"));
+	expect(wider.rendered == 3 && wider.pages == std::vector<int>{3, 4, 5}, "range with uncached page is rendered");
+
+	Export full = exportPages(exporter, fake, file, outputDir, PageSet());
+	expect(full.rendered == FakeExporter::pageCount && full.pages.size() == FakeExporter::pageCount, "all pages are rendered");
+	Export afterFull = exportPages(exporter, fake, file, outputDir, PageSet::parse("0,7-8,40-59"));
+	expect(afterFull.rendered == 0 && afterFull.pages == std::vector<int>{0, 7, 8}, "subset after full export is served from cache");
+	Export allAgain = exportPages(exporter, fake, file, outputDir, PageSet());
+	expect(allAgain.rendered == 0 && allAgain.pages.size() == FakeExporter::pageCount, "all pages are served from cache");
+
+	tc::stdfs::remove_all(root);
+	return failures;
+}
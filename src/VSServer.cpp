@@ -0,0 +1,310 @@
+#include "VSServer.h"
+
+#include <stdexcept>
+
+#include "VSUtils.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "VSAsyncConverter.h"
+#include "VSBatch.h"
+
+namespace
+{
+
+constexpr std::uint32_t maxFrameSize = 1 << 20;
+
+bool readAll(int fd, void* data, std::size_t size)
+{
+	char* bytes = static_cast<char*>(data);
+	while(size > 0)
+	{
+		ssize_t received = ::read(fd, bytes, size);
+		if(received < 0 && errno == EINTR) {
+			continue;
+		}
+		if(received <= 0) {
+			return false;
+		}
+		bytes += received;
+		size -= static_cast<std::size_t>(received);
+	}
+	return true;
+}
+
+bool writeAll(int fd, const void* data, std::size_t size)
+{
+	const char* bytes = static_cast<const char*>(data);
+	while(size > 0)
+	{
+		ssize_t written = ::write(fd, bytes, size);
+		if(written < 0 && errno == EINTR) {
+			continue;
+		}
+		if(written <= 0) {
+			return false;
+		}
+		bytes += written;
+		size -= static_cast<std::size_t>(written);
+	}
+	return true;
+}
+
+bool readFrame(int fd, std::string& payload)
+{
+	unsigned char header[4];
+	if(!readAll(fd, header, sizeof(header))) {
+		return false;
+	}
+	std::uint32_t size =
+		std::uint32_t(header[0]) << 24 | std::uint32_t(header[1]) << 16 | std::uint32_t(header[2]) << 8 | header[3];
+	if(size > maxFrameSize) {
+		return false;
+	}
+	payload.resize(size);
+	return readAll(fd, payload.data(), size);
+}
+
+bool writeFrame(int fd, const std::string& payload)
+{
+	std::uint32_t size = static_cast<std::uint32_t>(payload.size());
+	unsigned char header[4] = {
+		static_cast<unsigned char>(size >> 24), static_cast<unsigned char>(size >> 16),
+		static_cast<unsigned char>(size >> 8), static_cast<unsigned char>(size)
+	};
+	return writeAll(fd, header, sizeof(header)) && writeAll(fd, payload.data(), payload.size());
+}
+
+class Connection
+{
+public:
+	Connection(int fd, VSConverter::ExportOptions defaultOptions, std::shared_ptr<VSAsyncConverter> converter) :
+		m_fd(fd), m_defaultOptions(std::move(defaultOptions)), m_converter(std::move(converter))
+	{}
+	Connection(const Connection&) = delete;
+	Connection& operator=(const Connection&) = delete;
+
+	~Connection()
+	{
+		cancel();
+		if(m_waiter.joinable()) {
+			m_waiter.join();
+		}
+		::close(m_fd);
+	}
+
+	void serve()
+	{
+		std::string payload;
+		while(readFrame(m_fd, payload))
+		{
+			std::size_t newline = payload.find('\n');
+			std::string command = payload.substr(0, newline);
+			std::string argument = newline == std::string::npos ? std::string() : payload.substr(newline + 1);
+			if(command == "convert" || command == "thumbnail")
+			{
+				if(m_busy) {
+					send("busy");
+					continue;
+				}
+				if(m_waiter.joinable()) {
+					m_waiter.join();
+				}
+				submit(command == "thumbnail", argument);
+			}
+			else if(command == "cancel") {
+				cancel();
+			}
+			else {
+				send("error\nUnknown command " + command);
+			}
+		}
+	}
+
+private:
+	void submit(bool thumbnail, const std::string& entry)
+	{
+		try
+		{
+			VSBatch::Job job = VSBatch::parseEntry(entry, m_defaultOptions);
+			std::lock_guard lock(m_handleMutex);
+			if(thumbnail) {
+				m_handle = m_converter->submitThumbnail(std::move(job));
+			}
+			else
+			{
+				m_handle = m_converter->submit(
+					std::move(job), VSAsyncConverter::Priority::Normal,
+					[this](const VSConverter::String& imageName, std::size_t) {
+						send("image\n" + imageName);
+					}
+				);
+			}
+		}
+		catch(const std::exception& e)
+		{
+			send(std::string("error\n") + e.what());
+			return;
+		}
+		m_busy = true;
+		m_waiter = std::thread(&Connection::wait, this, thumbnail);
+	}
+
+	///@brief Sends result of submitted job once it is finished.
+	void wait(bool thumbnail)
+	{
+		std::string result;
+		try
+		{
+			VSAsyncConverter::Images images = m_handle->future().get();
+			if(thumbnail) {
+				send("image\n" + images.front());
+			}
+			result = "done";
+		}
+		catch(const tc::err::exc::Timeout&)
+		{
+			result = "timeout";
+		}
+		catch(const tc::err::exc::Interrupted&)
+		{
+			result = "cancelled";
+		}
+		catch(const std::exception& e)
+		{
+			result = std::string("error\n") + e.what();
+		}
+		m_busy = false;
+		send(result);
+	}
+
+	void cancel()
+	{
+		std::lock_guard lock(m_handleMutex);
+		if(m_handle) {
+			m_handle->cancel();
+		}
+	}
+
+	void send(const std::string& payload)
+	{
+		std::lock_guard lock(m_sendMutex);
+		writeFrame(m_fd, payload);
+	}
+
+	int m_fd;
+	VSConverter::ExportOptions m_defaultOptions;
+	std::shared_ptr<VSAsyncConverter> m_converter;
+	std::mutex m_sendMutex;
+	std::mutex m_handleMutex;
+	//Handle of the last submitted job, replaced only while no job is running.
+	std::optional<VSAsyncConverter::Handle> m_handle;
+	std::atomic_bool m_busy = false;
+	std::thread m_waiter;
+};
+
+}
+
+VSServer::VSServer(VSConverter& converter, std::size_t jobs, Path socketPath, VSConverter::ExportOptions defaultOptions) :
+	m_converter(converter), m_jobs(jobs), m_socketPath(std::move(socketPath)), m_defaultOptions(std::move(defaultOptions))
+{
+	assert(m_jobs > 0);
+}
+
+void VSServer::setMaxConnections(std::size_t maxConnections)
+{
+	m_maxConnections = maxConnections;
+}
+
+void VSServer::run()
+{
+	std::signal(SIGPIPE, SIG_IGN);
+
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	std::string path = m_socketPath.string();
+	if(path.empty() || path.size() >= sizeof(address.sun_path)) {
+		throw tc::err::exc::InvalidArgument("Invalid socket path");
+	}
+	std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+	std::error_code err;
+	if(tc::stdfs::is_socket(m_socketPath, err)) {
+		tc::stdfs::remove(m_socketPath, err);
+	}
+	int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd < 0) {
+		throw std::runtime_error("Unable to create socket");
+	}
+	if(::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, SOMAXCONN) != 0)
+	{
+		::close(fd);
+		throw std::runtime_error("Unable to listen on socket " + path + ": " + std::strerror(errno));
+	}
+	//Shared with connections, which are detached and may outlive this call if it throws.
+	auto converter = std::make_shared<VSAsyncConverter>(m_converter, m_jobs);
+	for(;;)
+	{
+		int client = ::accept(fd, nullptr, nullptr);
+		if(client < 0)
+		{
+			if(errno == EINTR || errno == ECONNABORTED) {
+				continue;
+			}
+			//Pending connection stays queued until connections close their descriptors.
+			if(errno == EMFILE || errno == ENFILE)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(100));
+				continue;
+			}
+			::close(fd);
+			throw std::runtime_error(std::string("Unable to accept connection: ") + std::strerror(errno));
+		}
+		if(++*m_connectionCount > m_maxConnections)
+		{
+			--*m_connectionCount;
+			writeFrame(client, "busy");
+			::close(client);
+			continue;
+		}
+		std::thread([client, options = m_defaultOptions, converter, connectionCount = m_connectionCount] {
+			Connection(client, options, converter).serve();
+			--*connectionCount;
+		}).detach();
+	}
+}
+
+#else
+
+VSServer::VSServer(VSConverter& converter, std::size_t jobs, Path socketPath, VSConverter::ExportOptions defaultOptions) :
+	m_converter(converter), m_jobs(jobs), m_socketPath(std::move(socketPath)), m_defaultOptions(std::move(defaultOptions))
+{
+	assert(m_jobs > 0);
+}
+
+void VSServer::setMaxConnections(std::size_t maxConnections)
+{
+	m_maxConnections = maxConnections;
+}
+
+void VSServer::run()
+{
+	throw std::runtime_error("Server mode is not supported on this platform");
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "VSConverter.h"
+
+///@brief Serves conversions over local Unix domain socket keeping backends loaded between requests.
+///
+/// Every message in both directions is a frame: 4-byte big-endian payload length followed by payload.
+/// Payload is a command optionally followed by '\n' and its argument.
+/// Requests:
+/// "convert\n<manifest entry>" - starts conversion, entry has the same format as lines of VSBatch manifest;
+/// "thumbnail\n<manifest entry>" - starts generation of thumbnail of the first selected page of entry;
+/// "cancel" - cancels conversion or thumbnail running on the connection.
+/// Responses to convert and thumbnail:
+/// "image\n<name>" for every produced image, then one of "done", "cancelled", "timeout" or "error\n<message>",
+/// or single "busy" if conversion is already running on the connection.
+/// One conversion runs on a connection at a time, clients open several connections for concurrent conversions.
+/// Conversions of all connections share backends of one VSAsyncConverter, so at most jobs of them run at once and
+/// queued thumbnails are started before queued conversions. Cancel affects conversion of its own connection only.
+/// Connections beyond the maximum number of served ones receive single "busy" and are closed.
+class VSServer
+{
+public:
+	using Path = VSConverter::Path;
+
+	///@param converter must outlive this instance and connections it serves, caches of converter are shared
+	/// by all connections.
+	///@param jobs is number of conversions running at once.
+	VSServer(VSConverter& converter, std::size_t jobs, Path socketPath, VSConverter::ExportOptions defaultOptions);
+
+	///@brief Limits number of connections served at once, every one holds its thread.
+	void setMaxConnections(std::size_t maxConnections);
+
+	///@brief Listens on socket and serves connections until process termination.
+	///@throw std::runtime_error if socket can not be listened.
+	[[noreturn]] void run();
+
+private:
+	VSConverter& m_converter;
+	std::size_t m_jobs;
+	Path m_socketPath;
+	VSConverter::ExportOptions m_defaultOptions;
+	std::size_t m_maxConnections = 64;
+	std::shared_ptr<std::atomic<std::size_t>> m_connectionCount = std::make_shared<std::atomic<std::size_t>>(0);
+};
\ No newline at end of file
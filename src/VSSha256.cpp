@@ -0,0 +1,150 @@
+#include "VSSha256.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace tc
+{
+
+namespace
+{
+
+constexpr std::uint32_t roundConstants[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+constexpr std::uint32_t rotr(std::uint32_t x, int n) {
+	return (x >> n) | (x << (32 - n));
+}
+
+}
+
+Sha256::Sha256() :
+	m_state{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19}
+{}
+
+Sha256& Sha256::update(const void* data, std::size_t size)
+{
+	const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+	m_size += size;
+	while(size > 0)
+	{
+		std::size_t count = std::min(size, m_block.size() - m_blockSize);
+		std::memcpy(m_block.data() + m_blockSize, bytes, count);
+		m_blockSize += count;
+		bytes += count;
+		size -= count;
+		if(m_blockSize == m_block.size())
+		{
+			transform(m_block.data());
+			m_blockSize = 0;
+		}
+	}
+	return *this;
+}
+
+auto Sha256::finish() -> Digest
+{
+	std::uint64_t bitSize = m_size * 8;
+	std::uint8_t padding[72] = {0x80};
+	std::size_t paddingSize = (m_blockSize < 56 ? 56 : 120) - m_blockSize;
+	for(int i = 0; i < 8; ++i) {
+		padding[paddingSize + i] = static_cast<std::uint8_t>(bitSize >> (56 - 8 * i));
+	}
+	update(padding, paddingSize + 8);
+	Digest digest;
+	for(std::size_t i = 0; i < m_state.size(); ++i)
+	{
+		for(int j = 0; j < 4; ++j) {
+			digest[i * 4 + j] = static_cast<std::uint8_t>(m_state[i] >> (24 - 8 * j));
+		}
+	}
+	return digest;
+}
+
+std::string Sha256::toHex(const Digest& digest)
+{
+	static const char hexDigits[] = "0123456789abcdef";
+	std::string hex;
+	hex.reserve(digest.size() * 2);
+	for(std::uint8_t byte : digest)
+	{
+		hex += hexDigits[byte >> 4];
+		hex += hexDigits[byte & 0xf];
+	}
+	return hex;
+}
+
+auto Sha256::ofFile(const tc::stdfs::path& file) -> Digest
+{
+	std::ifstream stream(file, std::ios::binary);
+	if(!stream) {
+		throw std::runtime_error("Unable to read file " + file.string());
+	}
+	Sha256 sha;
+	std::vector<char> buffer(1 << 16);
+	while(stream)
+	{
+		stream.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+		sha.update(buffer.data(), static_cast<std::size_t>(stream.gcount()));
+	}
+	if(stream.bad()) {
+		throw std::runtime_error("Unable to read file " + file.string());
+	}
+	return sha.finish();
+}
+
+void Sha256::transform(const std::uint8_t* block)
+{
+	std::uint32_t w[64];
+	for(int i = 0; i < 16; ++i)
+	{
+		w[i] = std::uint32_t(block[i * 4]) << 24 | std::uint32_t(block[i * 4 + 1]) << 16 |
+			std::uint32_t(block[i * 4 + 2]) << 8 | std::uint32_t(block[i * 4 + 3]);
+	}
+	for(int i = 16; i < 64; ++i)
+	{
+		std::uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+		std::uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+	std::uint32_t a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+	std::uint32_t e = m_state[4], f = m_state[5], g = m_state[6], h = m_state[7];
+	for(int i = 0; i < 64; ++i)
+	{
+		std::uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+		std::uint32_t ch = (e & f) ^ (~e & g);
+		std::uint32_t t1 = h + s1 + ch + roundConstants[i] + w[i];
+		std::uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+		std::uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+		std::uint32_t t2 = s0 + maj;
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+	m_state[0] += a;
+	m_state[1] += b;
+	m_state[2] += c;
+	m_state[3] += d;
+	m_state[4] += e;
+	m_state[5] += f;
+	m_state[6] += g;
+	m_state[7] += h;
+}
+
+} //namespace tc
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "VSNamespace.h"
+
+namespace tc
+{
+
+///@brief Incremental SHA-256 digest.
+class Sha256
+{
+public:
+	using Digest = std::array<std::uint8_t, 32>;
+
+	Sha256();
+
+	Sha256& update(const void* data, std::size_t size);
+	Sha256& update(std::string_view data) {
+		return update(data.data(), data.size());
+	}
+	///@brief Finishes digest, object must not be updated after this call.
+	Digest finish();
+
+	static std::string toHex(const Digest& digest);
+	///@throw std::runtime_error if @p file can not be read.
+	static Digest ofFile(const tc::stdfs::path& file);
+
+private:
+	void transform(const std::uint8_t* block);
+
+	std::array<std::uint32_t, 8> m_state;
+	std::array<std::uint8_t, 64> m_block;
+	std::size_t m_blockSize = 0;
+	std::uint64_t m_size = 0;
+};
+
+} //namespace tc
\ No newline at end of file
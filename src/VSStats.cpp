@@ -0,0 +1,81 @@
+#include "VSStats.h"
+
+#include "VSJson.h"
+
+namespace
+{
+
+double secondsOf(std::chrono::steady_clock::duration duration)
+{
+	return std::chrono::duration<double>(duration).count();
+}
+
+}
+
+VSStats::VSStats() :
+	m_start(std::chrono::steady_clock::now())
+{}
+
+void VSStats::onStage(const tc::file_as_img::StageEvent& event)
+{
+	std::lock_guard lock(m_mutex);
+	add(m_stages, event);
+	Document& document = m_documents[event.file.string()];
+	add(document.stages, event);
+	if(event.page >= 0) {
+		add(document.pages[event.page], event);
+	}
+}
+
+void VSStats::writeJson(std::ostream& out) const
+{
+	std::lock_guard lock(m_mutex);
+	out << "{\"seconds\":" << secondsOf(std::chrono::steady_clock::now() - m_start) << ",\"stages\":";
+	writeJson(out, m_stages);
+	out << ",\"documents\":[";
+	bool firstDocument = true;
+	for(const auto& [file, document] : m_documents)
+	{
+		out << (firstDocument ? "" : ",") << "{\"file\":" << tc::json::quoted(file) << ",\"stages\":";
+		firstDocument = false;
+		writeJson(out, document.stages);
+		out << ",\"pages\":[";
+		bool firstPage = true;
+		for(const auto& [page, stages] : document.pages)
+		{
+			out << (firstPage ? "" : ",") << "{\"page\":" << page << ",\"stages\":";
+			firstPage = false;
+			writeJson(out, stages);
+			out << "}";
+		}
+		out << "]}";
+	}
+	out << "]}" << std::endl;
+}
+
+void VSStats::add(StageTotals& totals, const tc::file_as_img::StageEvent& event)
+{
+	Totals& stage = totals[static_cast<std::size_t>(event.stage)];
+	++stage.count;
+	stage.duration += event.end - event.start;
+	stage.pixels += event.pixels;
+	stage.bytes += event.bytes;
+}
+
+void VSStats::writeJson(std::ostream& out, const StageTotals& totals)
+{
+	out << "{";
+	bool first = true;
+	for(std::size_t i = 0; i < totals.size(); ++i)
+	{
+		const Totals& stage = totals[i];
+		if(stage.count == 0) {
+			continue;
+		}
+		out << (first ? "" : ",") << tc::json::quoted(tc::file_as_img::nameOf(static_cast<tc::file_as_img::Stage>(i)))
+			<< ":{\"count\":" << stage.count << ",\"seconds\":" << secondsOf(stage.duration)
+			<< ",\"pixels\":" << stage.pixels << ",\"bytes\":" << stage.bytes << "}";
+		first = false;
+	}
+	out << "}";
+}
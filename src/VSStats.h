@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+#include "VSExportObserver.h"
+
+///@brief Aggregates stages reported by backends per document, per page and per stage,
+/// and writes them as JSON report:
+/// {"seconds":12.5,"stages":{"load":{"count":2,"seconds":0.4,"pixels":0,"bytes":0},...},
+/// "documents":[{"file":"a.pdf","stages":{...},"pages":[{"page":0,"stages":{...}},...]},...]}.
+/// Seconds of stages are summed over threads, so they may exceed wall clock seconds of the run.
+/// Only stages which have run are listed.
+class VSStats : public tc::file_as_img::IExportObserver
+{
+public:
+	VSStats();
+	VSStats(const VSStats&) = delete;
+	VSStats& operator=(const VSStats&) = delete;
+
+	void onStage(const tc::file_as_img::StageEvent& event) override;
+
+	///@brief Writes report of stages reported so far, wall clock seconds are counted from construction.
+	void writeJson(std::ostream& out) const;
+
+private:
+	struct Totals
+	{
+		std::uint64_t count = 0;
+		std::chrono::steady_clock::duration duration{};
+		std::uint64_t pixels = 0;
+		std::uint64_t bytes = 0;
+	};
+
+	static constexpr std::size_t stageCount = static_cast<std::size_t>(tc::file_as_img::Stage::Write) + 1;
+	using StageTotals = std::array<Totals, stageCount>;
+
+	struct Document
+	{
+		StageTotals stages;
+		std::map<int, StageTotals> pages;
+	};
+
+	static void add(StageTotals& totals, const tc::file_as_img::StageEvent& event);
+	static void writeJson(std::ostream& out, const StageTotals& totals);
+
+	std::chrono::steady_clock::time_point m_start;
+	mutable std::mutex m_mutex;
+	StageTotals m_stages;
+	std::map<std::string, Document> m_documents;
+};
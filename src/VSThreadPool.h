@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tc
+{
+
+///@brief Fixed number of threads executing posted tasks, tasks of higher priority first, tasks of equal priority
+/// in FIFO order. Running tasks are not preempted by tasks of higher priority.
+/// Tasks must not throw, destructor executes all queued tasks before joining threads.
+class ThreadPool
+{
+public:
+	using Task = std::function<void()>;
+
+	explicit ThreadPool(std::size_t threadCount)
+	{
+		assert(threadCount > 0);
+		for(std::size_t i = 0; i < threadCount; ++i) {
+			m_threads.emplace_back(&ThreadPool::run, this);
+		}
+	}
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_stopped = true;
+		}
+		m_taskAvailable.notify_all();
+		for(std::thread& thread : m_threads) {
+			thread.join();
+		}
+	}
+
+	void post(Task task, int priority = 0)
+	{
+		assert(task);
+		{
+			std::lock_guard lock(m_mutex);
+			m_tasks[priority].push_back(std::move(task));
+			++m_unfinished;
+		}
+		m_taskAvailable.notify_one();
+	}
+
+	///@brief Blocks until all posted tasks are finished.
+	void wait()
+	{
+		std::unique_lock lock(m_mutex);
+		m_idle.wait(lock, [this] { return m_unfinished == 0; });
+	}
+
+private:
+	void run()
+	{
+		std::unique_lock lock(m_mutex);
+		for(;;)
+		{
+			m_taskAvailable.wait(lock, [this] { return m_stopped || !m_tasks.empty(); });
+			if(m_tasks.empty()) {
+				return;
+			}
+			auto highest = m_tasks.begin();
+			Task task = std::move(highest->second.front());
+			highest->second.pop_front();
+			if(highest->second.empty()) {
+				m_tasks.erase(highest);
+			}
+			lock.unlock();
+			task();
+			lock.lock();
+			if(--m_unfinished == 0) {
+				m_idle.notify_all();
+			}
+		}
+	}
+
+	std::mutex m_mutex;
+	//Separate conditions, so notification of posted task always wakes thread of pool rather than waiter of wait().
+	std::condition_variable m_taskAvailable;
+	std::condition_variable m_idle;
+	//Only priorities with queued tasks are present.
+	std::map<int, std::deque<Task>, std::greater<int>> m_tasks;
+	std::size_t m_unfinished = 0;
+	bool m_stopped = false;
+	std::vector<std::thread> m_threads;
+};
+
+} //namespace tc
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "VSTraceRecorder.h"
+
+#include <unistd.h>
+
+#include "VSJson.h"
+
+namespace
+{
+
+long long microsecondsOf(std::chrono::steady_clock::duration duration)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+}
+
+VSTraceRecorder::VSTraceRecorder() :
+	m_start(std::chrono::steady_clock::now())
+{}
+
+void VSTraceRecorder::onStage(const tc::file_as_img::StageEvent& event)
+{
+	std::lock_guard lock(m_mutex);
+	m_spans.push_back({
+		event.stage, event.file.string(), event.page, event.start - m_start, event.end - event.start,
+		threadNumberOf(event.thread), event.pixels, event.bytes
+	});
+}
+
+void VSTraceRecorder::writeJson(std::ostream& out) const
+{
+	std::lock_guard lock(m_mutex);
+	const long pid = ::getpid();
+	out << "{\"traceEvents\":[";
+	bool first = true;
+	for(const auto& [thread, number] : m_threads)
+	{
+		out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << number
+			<< ",\"args\":{\"name\":" << tc::json::quoted("thread " + std::to_string(number)) << "}}";
+		first = false;
+	}
+	for(const Span& span : m_spans)
+	{
+		out << (first ? "" : ",") << "\n{\"name\":" << tc::json::quoted(tc::file_as_img::nameOf(span.stage))
+			<< ",\"cat\":\"export\",\"ph\":\"X\",\"ts\":" << microsecondsOf(span.start)
+			<< ",\"dur\":" << microsecondsOf(span.duration) << ",\"pid\":" << pid << ",\"tid\":" << span.thread
+			<< ",\"args\":{\"file\":" << tc::json::quoted(span.file);
+		if(span.page >= 0) {
+			out << ",\"page\":" << span.page;
+		}
+		out << ",\"pixels\":" << span.pixels << ",\"bytes\":" << span.bytes << "}}";
+		first = false;
+	}
+	out << "\n],\"displayTimeUnit\":\"ms\"}" << std::endl;
+}
+
+int VSTraceRecorder::threadNumberOf(std::thread::id thread)
+{
+	return m_threads.try_emplace(thread, static_cast<int>(m_threads.size()) + 1).first->second;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "VSExportObserver.h"
+
+///@brief Records stages reported by backends as spans and writes them as Chrome trace event JSON,
+/// which is opened by chrome://tracing and ui.perfetto.dev:
+/// {"traceEvents":[{"name":"render","cat":"export","ph":"X","ts":1200,"dur":35000,"pid":1,"tid":2,
+/// "args":{"file":"a.pdf","page":0,"pixels":1920000,"bytes":0}},...],"displayTimeUnit":"ms"}.
+/// Times are microseconds from construction of recorder, threads are numbered in order of their first span
+/// and named by metadata events. Gaps between spans of a thread show where it waited for queues or locks.
+class VSTraceRecorder : public tc::file_as_img::IExportObserver
+{
+public:
+	VSTraceRecorder();
+	VSTraceRecorder(const VSTraceRecorder&) = delete;
+	VSTraceRecorder& operator=(const VSTraceRecorder&) = delete;
+
+	void onStage(const tc::file_as_img::StageEvent& event) override;
+
+	///@brief Writes spans recorded so far.
+	void writeJson(std::ostream& out) const;
+
+private:
+	struct Span
+	{
+		tc::file_as_img::Stage stage;
+		std::string file;
+		int page;
+		std::chrono::steady_clock::duration start;
+		std::chrono::steady_clock::duration duration;
+		int thread;
+		std::uint64_t pixels;
+		std::uint64_t bytes;
+	};
+
+	int threadNumberOf(std::thread::id thread);
+
+	std::chrono::steady_clock::time_point m_start;
+	mutable std::mutex m_mutex;
+	std::vector<Span> m_spans;
+	std::map<std::thread::id, int> m_threads;
+};
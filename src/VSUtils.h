@@ -52,6 +52,14 @@ public:
 	using std::runtime_error::runtime_error;
 };
 
+///@brief Operation has been interrupted because it has exceeded its time budget.
+class Timeout : public Interrupted
+{
+public:
+	Timeout() : Interrupted("Operation has exceeded its time budget") {}
+	using Interrupted::Interrupted;
+};
+
 class InvalidArgument : public std::runtime_error
 {
 public:
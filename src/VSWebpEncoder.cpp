@@ -0,0 +1,86 @@
+#include "VSWebpEncoder.h"
+
+#include <cassert>
+#include <exception>
+#include <stdexcept>
+#include <string>
+
+#include <webp/encode.h>
+
+namespace tc::file_as_img::enc
+{
+
+namespace
+{
+
+struct Writer
+{
+	const Sink* sink;
+	std::exception_ptr sinkError;
+
+	static int write(const std::uint8_t* data, std::size_t size, const WebPPicture* picture)
+	{
+		auto* writer = static_cast<Writer*>(picture->custom_ptr);
+		try {
+			(*writer->sink)(data, size);
+		}
+		catch(...)
+		{
+			writer->sinkError = std::current_exception();
+			return 0;
+		}
+		return 1;
+	}
+};
+
+}
+
+void encodeWebp(
+	const std::uint8_t* pixels, std::size_t width, std::size_t height, std::ptrdiff_t stride,
+	const WebpOptions& options, const Sink& sink
+)
+{
+	if(width == 0 || height == 0 || width > WEBP_MAX_DIMENSION || height > WEBP_MAX_DIMENSION) {
+		throw tc::err::exc::InvalidArgument("Invalid size of webp image");
+	}
+	assert(stride % 4 == 0);
+	assert(sink);
+
+	WebPConfig config;
+	if(!WebPConfigInit(&config)) {
+		throw std::runtime_error("Incompatible libwebp version");
+	}
+	config.lossless = options.lossless ? 1 : 0;
+	config.quality = options.quality;
+	config.method = options.method;
+	//Encoder would otherwise modify colour of transparent pixels in place.
+	config.exact = 1;
+	if(!WebPValidateConfig(&config)) {
+		throw tc::err::exc::InvalidArgument("Invalid webp options");
+	}
+
+	WebPPicture picture;
+	if(!WebPPictureInit(&picture)) {
+		throw std::runtime_error("Incompatible libwebp version");
+	}
+	Writer writer{&sink, nullptr};
+	picture.use_argb = 1;
+	picture.width = static_cast<int>(width);
+	picture.height = static_cast<int>(height);
+	//Picture only views pixels, WebPPictureFree releases buffers allocated by encoder, e.g. YUV planes of lossy one.
+	picture.argb = const_cast<std::uint32_t*>(reinterpret_cast<const std::uint32_t*>(pixels));
+	picture.argb_stride = static_cast<int>(stride / 4);
+	picture.writer = &Writer::write;
+	picture.custom_ptr = &writer;
+	int encoded = WebPEncode(&config, &picture);
+	WebPEncodingError error = picture.error_code;
+	WebPPictureFree(&picture);
+	if(writer.sinkError) {
+		std::rethrow_exception(writer.sinkError);
+	}
+	if(!encoded) {
+		throw std::runtime_error("Webp encoding error " + std::to_string(static_cast<int>(error)));
+	}
+}
+
+} //namespace tc::file_as_img::enc
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "VSExportOptions.h"
+#include "VSImageEncoder.h"
+
+namespace tc::file_as_img::enc
+{
+
+///@brief Encodes image of argb32 rows by libwebp, row i starts at @p pixels + i * @p stride bytes.
+///
+/// argb32 is the native pixel layout of libwebp, so pixels are passed to encoder in place without conversion.
+///@pre @p stride is multiple of 4.
+///@throw tc::err::exc::InvalidArgument on invalid options or empty image.
+///@throw std::runtime_error on encoding error, exception thrown by sink is rethrown as is.
+void encodeWebp(
+	const std::uint8_t* pixels, std::size_t width, std::size_t height, std::ptrdiff_t stride,
+	const WebpOptions& options, const Sink& sink
+);
+
+} //namespace tc::file_as_img::enc
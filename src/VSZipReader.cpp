@@ -0,0 +1,149 @@
+#include "VSZipReader.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <zlib.h>
+
+namespace tc::file_as_img
+{
+
+namespace
+{
+
+constexpr std::uint32_t endOfCentralDirectorySignature = 0x06054b50;
+constexpr std::uint32_t centralDirectoryEntrySignature = 0x02014b50;
+constexpr std::uint32_t localHeaderSignature = 0x04034b50;
+constexpr std::size_t endOfCentralDirectorySize = 22;
+constexpr std::size_t centralDirectoryEntrySize = 46;
+constexpr std::size_t localHeaderSize = 30;
+constexpr std::size_t maxCommentSize = 0xFFFF;
+
+std::uint16_t u16At(const std::vector<std::uint8_t>& bytes, std::size_t offset)
+{
+	return static_cast<std::uint16_t>(bytes.at(offset) | bytes.at(offset + 1) << 8);
+}
+
+std::uint32_t u32At(const std::vector<std::uint8_t>& bytes, std::size_t offset)
+{
+	return static_cast<std::uint32_t>(u16At(bytes, offset)) | static_cast<std::uint32_t>(u16At(bytes, offset + 2)) << 16;
+}
+
+std::vector<std::uint8_t> inflateRaw(const std::vector<std::uint8_t>& compressed, std::size_t size)
+{
+	std::vector<std::uint8_t> result(size);
+	z_stream stream{};
+	if(inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+		throw std::runtime_error("Unable to initialize inflate");
+	}
+	stream.next_in = const_cast<Bytef*>(compressed.data());
+	stream.avail_in = static_cast<uInt>(compressed.size());
+	stream.next_out = result.data();
+	stream.avail_out = static_cast<uInt>(result.size());
+	int status = inflate(&stream, Z_FINISH);
+	inflateEnd(&stream);
+	if(status != Z_STREAM_END || stream.avail_out != 0) {
+		throw std::runtime_error("Corrupted zip entry");
+	}
+	return result;
+}
+
+}
+
+ZipReader::ZipReader(const Path& file) :
+	m_file(file, std::ios::binary)
+{
+	if(!m_file) {
+		throw std::runtime_error("Unable to open " + file.string());
+	}
+	m_file.seekg(0, std::ios::end);
+	m_fileSize = static_cast<std::uint64_t>(m_file.tellg());
+	if(m_fileSize < endOfCentralDirectorySize) {
+		throw std::runtime_error("Not a zip archive " + file.string());
+	}
+
+	//End of central directory record is followed only by archive comment of at most 64K.
+	std::size_t tailSize = static_cast<std::size_t>(std::min<std::uint64_t>(m_fileSize, endOfCentralDirectorySize + maxCommentSize));
+	std::vector<std::uint8_t> tail = readAt(m_fileSize - tailSize, tailSize);
+	std::size_t end = tailSize - endOfCentralDirectorySize + 1;
+	do
+	{
+		--end;
+		if(u32At(tail, end) == endOfCentralDirectorySignature) {
+			break;
+		}
+	} while(end > 0);
+	if(u32At(tail, end) != endOfCentralDirectorySignature) {
+		throw std::runtime_error("Not a zip archive " + file.string());
+	}
+	std::uint16_t entryCount = u16At(tail, end + 10);
+	std::uint32_t directorySize = u32At(tail, end + 12);
+	std::uint32_t directoryOffset = u32At(tail, end + 16);
+	if(entryCount == 0xFFFF || directoryOffset == 0xFFFFFFFF) {
+		throw std::runtime_error("ZIP64 archives are not supported");
+	}
+
+	std::vector<std::uint8_t> directory = readAt(directoryOffset, directorySize);
+	std::size_t offset = 0;
+	for(std::uint16_t i = 0; i < entryCount; ++i)
+	{
+		if(offset + centralDirectoryEntrySize > directory.size() || u32At(directory, offset) != centralDirectoryEntrySignature) {
+			throw std::runtime_error("Corrupted zip central directory");
+		}
+		Entry entry{
+			u16At(directory, offset + 10), u32At(directory, offset + 16), u32At(directory, offset + 20),
+			u32At(directory, offset + 24), u32At(directory, offset + 42)
+		};
+		std::size_t nameSize = u16At(directory, offset + 28);
+		std::size_t extraSize = u16At(directory, offset + 30);
+		std::size_t commentSize = u16At(directory, offset + 32);
+		if(offset + centralDirectoryEntrySize + nameSize > directory.size()) {
+			throw std::runtime_error("Corrupted zip central directory");
+		}
+		auto name = reinterpret_cast<const char*>(directory.data() + offset + centralDirectoryEntrySize);
+		m_entries.emplace(std::string(name, nameSize), entry);
+		offset += centralDirectoryEntrySize + nameSize + extraSize + commentSize;
+	}
+}
+
+auto ZipReader::read(const std::string& name, std::size_t maxSize) const -> std::optional<std::vector<std::uint8_t>>
+{
+	auto it = m_entries.find(name);
+	if(it == m_entries.end() || it->second.size > maxSize) {
+		return std::nullopt;
+	}
+	const Entry& entry = it->second;
+	std::vector<std::uint8_t> header = readAt(entry.localHeaderOffset, localHeaderSize);
+	if(u32At(header, 0) != localHeaderSignature) {
+		throw std::runtime_error("Corrupted zip entry " + name);
+	}
+	std::uint64_t dataOffset = std::uint64_t(entry.localHeaderOffset) + localHeaderSize + u16At(header, 26) + u16At(header, 28);
+	std::vector<std::uint8_t> data = readAt(dataOffset, entry.compressedSize);
+	if(entry.method == 8) {
+		data = inflateRaw(data, entry.size);
+	}
+	else if(entry.method != 0 || entry.compressedSize != entry.size) {
+		throw std::runtime_error("Unsupported compression of zip entry " + name);
+	}
+	if(crc32(0, data.data(), static_cast<uInt>(data.size())) != entry.crc) {
+		throw std::runtime_error("Corrupted zip entry " + name);
+	}
+	return data;
+}
+
+std::vector<std::uint8_t> ZipReader::readAt(std::uint64_t offset, std::size_t size) const
+{
+	if(offset > m_fileSize || size > m_fileSize - offset) {
+		throw std::runtime_error("Corrupted zip archive");
+	}
+	std::vector<std::uint8_t> bytes(size);
+	m_file.clear();
+	m_file.seekg(static_cast<std::streamoff>(offset));
+	m_file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(size));
+	if(!m_file) {
+		throw std::runtime_error("Unable to read zip archive");
+	}
+	return bytes;
+}
+
+} //namespace tc::file_as_img
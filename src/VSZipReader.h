@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "VSNamespace.h"
+
+namespace tc::file_as_img
+{
+
+///@brief Reads single entries of zip archive, e.g. OOXML or ODF package, without extracting the rest of it.
+/// Stored and deflated entries are supported, ZIP64 archives are not.
+class ZipReader
+{
+public:
+	using Path = tc::stdfs::path;
+
+	///@brief Reads central directory of @p file.
+	///@throw std::runtime_error if @p file can not be read or is not zip archive.
+	explicit ZipReader(const Path& file);
+	ZipReader(const ZipReader&) = delete;
+	ZipReader& operator=(const ZipReader&) = delete;
+
+	bool contains(const std::string& name) const {
+		return m_entries.count(name) > 0;
+	}
+
+	///@return uncompressed content of entry @p name, nullopt if there is no such entry or it is larger than @p maxSize.
+	///@throw std::runtime_error if entry is corrupted or compressed by unsupported method.
+	std::optional<std::vector<std::uint8_t>> read(const std::string& name, std::size_t maxSize) const;
+
+private:
+	struct Entry
+	{
+		std::uint16_t method;
+		std::uint32_t crc;
+		std::uint32_t compressedSize;
+		std::uint32_t size;
+		std::uint32_t localHeaderOffset;
+	};
+
+	std::vector<std::uint8_t> readAt(std::uint64_t offset, std::size_t size) const;
+
+	mutable std::ifstream m_file;
+	std::uint64_t m_fileSize = 0;
+	std::unordered_map<std::string, Entry> m_entries;
+};
+
+} //namespace tc::file_as_img
@@ -1,24 +1,90 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 #include <boost/program_options.hpp>
 
-#include "VSAsposeSlidesManager.h"
-#include "VSQtPdfManager.h"
+#ifdef __APPLE__
+#include <climits>
+#include <cstdint>
+#include <mach-o/dyld.h>
+#endif
+
+#include "VSBatch.h"
+#include "VSConverter.h"
 #include "VSExportFileAsImages.h"
+#include "VSExportOptions.h"
+#include "VSQtPdfManager.h"
+#include "VSRenderCache.h"
+#include "VSServer.h"
+#include "VSStats.h"
+#include "VSTraceRecorder.h"
 
 int main(int argc, char** argv)
 {
+	//Pdf worker processes run this executable with pageWorkerArgument, which is handled before anything else.
+	if(argc >= 2 && argv[1] == VSQtPdfManager::pageWorkerArgument) {
+		return VSQtPdfManager::runPageWorker(argc, argv);
+	}
+#if defined(__linux__)
+	VSQtPdfManager::setWorkerExecutable("/proc/self/exe");
+#elif defined(__APPLE__)
+	char executable[PATH_MAX];
+	std::uint32_t executableSize = sizeof(executable);
+	if(_NSGetExecutablePath(executable, &executableSize) == 0) {
+		VSQtPdfManager::setWorkerExecutable(executable);
+	}
+#endif
+
 	namespace opt = boost::program_options;
 	opt::options_description options;
 	options.add_options()
-	("input-file", opt::value<std::string>()->required())
-	("input-format", opt::value<std::string>()->required())
+	("input-file", opt::value<std::string>())
+	("input-format", opt::value<std::string>())
 	("output-dir", opt::value<std::string>()->default_value("."))
-	("output-format", opt::value<std::string>()->default_value("png"));
+	("output-format", opt::value<std::string>()->default_value("png"))
+	("stream", opt::value<int>()->implicit_value(1), "write images as frames to file descriptor, stdout by default, instead of output-dir")
+	("dpi", opt::value<double>()->default_value(96.0))
+	("workers", opt::value<std::size_t>()->default_value(1))
+	("band-height", opt::value<std::size_t>(), "render and encode pages of pdf in bands of this many rows")
+	("pages", opt::value<std::string>(), "zero based pages to export, e.g. 0,3,40-59")
+	("fit-within", opt::value<std::string>(), "render pages at the largest size fitting in box, e.g. 256x256")
+	("document-timeout", opt::value<std::size_t>(), "time budget of every document in milliseconds")
+	("page-timeout", opt::value<std::size_t>(), "time budget of rendering of every page in milliseconds")
+	("timeout-placeholder", "export pages exceeding page-timeout as blank placeholders instead of failing")
+	("draft", "fastest legible rendering, antialiasing and text hinting override its settings")
+	("antialiasing", opt::value<bool>(), "antialiasing of text, lines and images: 1 or 0")
+	("text-hinting", opt::value<bool>(), "fitting of glyphs to pixel grid: 1 or 0")
+	("background", opt::value<std::string>(), "background colour of transparent pages, e.g. ffffff")
+	("png-fast", "fast png encoding preset, png-level, png-filter and png-strategy override its settings")
+	("png-level", opt::value<int>(), "png compression level from 0 to 9")
+	("png-filter", opt::value<std::string>(), "png row filter: none, sub, up, average, paeth or adaptive")
+	("png-strategy", opt::value<std::string>(), "png deflate strategy: default, filtered, huffman, rle or fixed")
+	("jpeg-quality", opt::value<int>(), "jpeg quality from 1 to 100")
+	("jpeg-subsampling", opt::value<std::string>(), "jpeg chroma subsampling: 444, 422 or 420")
+	("jpeg-progressive", "progressive jpeg encoding")
+	("webp-lossless", "lossless webp encoding")
+	("webp-quality", opt::value<float>(), "webp quality of lossy or effort of lossless encoding from 0 to 100")
+	("webp-method", opt::value<int>(), "webp method from 0 (fastest) to 6 (smallest)")
+	("stats", opt::value<std::string>()->implicit_value("-"), "write JSON report of stage timings to file, stderr by default")
+	("trace", opt::value<std::string>(), "write Chrome trace event JSON of stages to file")
+	("manifest", opt::value<std::string>(), "batch manifest file, - for stdin")
+	("serve", opt::value<std::string>(), "Unix domain socket to serve conversions on")
+	("max-connections", opt::value<std::size_t>()->default_value(64), "maximum number of connections served at once")
+	("document-cache-mb", opt::value<std::size_t>()->default_value(0), "memory budget of loaded documents cache")
+	("render-cache-dir", opt::value<std::string>(), "directory of persistent cache of rendered images")
+	("render-cache-mb", opt::value<std::size_t>()->default_value(1024), "size limit of rendered images cache")
+	("jobs", opt::value<std::size_t>()->default_value(std::max(1u, std::thread::hardware_concurrency())));
 	opt::variables_map vars;
 	try
 	{
 		opt::store(opt::parse_command_line(argc, argv, options), vars);
+		if(!vars.count("manifest") && !vars.count("serve") && (!vars.count("input-file") || !vars.count("input-format"))) {
+			throw opt::error("input-file and input-format are required without manifest or serve");
+		}
 	}
 	catch(opt::error& e)
 	{
@@ -26,34 +92,218 @@ int main(int argc, char** argv)
 		return 1;
 	}
 
-	std::unique_ptr<tc::file_as_img::fs::IExporter> exporter;
-	std::string fileFormat = vars["input-format"].as<std::string>();
-	if(fileFormat == "pdf") {
-		exporter.reset(new VSQtPdfManager());
+	VSConverter converter;
+	tc::file_as_img::ExportOptions exportOptions;
+	exportOptions.dpi = vars["dpi"].as<double>();
+	exportOptions.workers = vars["workers"].as<std::size_t>();
+	if(vars.count("band-height")) {
+		exportOptions.bandHeight = vars["band-height"].as<std::size_t>();
+	}
+	if(vars.count("document-timeout")) {
+		exportOptions.timeouts.document = std::chrono::milliseconds(vars["document-timeout"].as<std::size_t>());
 	}
-	else {
-		exporter.reset(new VSAsposeSlidesManager());
+	if(vars.count("page-timeout")) {
+		exportOptions.timeouts.page = std::chrono::milliseconds(vars["page-timeout"].as<std::size_t>());
 	}
-	std::string imageFormat = vars["output-format"].as<std::string>();
+	exportOptions.timeouts.placeholder = vars.count("timeout-placeholder") > 0;
 	try
 	{
-		exporter->exportAsImages(
-			vars["input-file"].as<std::string>(),
-			fileFormat,
-			vars["output-dir"].as<std::string>(),
-			imageFormat,
-			tc::file_as_img::fs::IncrementNameGenerator(0, "." + imageFormat),
-			{},
-			[](const tc::file_as_img::fs::TypesHolder::String& name) {
-				std::cout << name << std::endl;
+		if(vars.count("pages")) {
+			exportOptions.pages = tc::file_as_img::PageSet::parse(vars["pages"].as<std::string>());
+		}
+		if(vars.count("fit-within")) {
+			exportOptions.fitWithin = tc::file_as_img::BoundingBox::parse(vars["fit-within"].as<std::string>());
+		}
+		if(vars.count("draft")) {
+			exportOptions.render = tc::file_as_img::RenderOptions::draft();
+		}
+		if(vars.count("antialiasing")) {
+			exportOptions.render.antialiasing = vars["antialiasing"].as<bool>();
+		}
+		if(vars.count("text-hinting")) {
+			exportOptions.render.textHinting = vars["text-hinting"].as<bool>();
+		}
+		if(vars.count("background")) {
+			exportOptions.render.background = tc::file_as_img::RenderOptions::parseColor(vars["background"].as<std::string>());
+		}
+		if(vars.count("png-fast")) {
+			exportOptions.png = tc::file_as_img::PngOptions::fast();
+		}
+		if(vars.count("png-level"))
+		{
+			exportOptions.png.compressionLevel = vars["png-level"].as<int>();
+			if(exportOptions.png.compressionLevel < 0 || exportOptions.png.compressionLevel > 9) {
+				throw tc::err::exc::InvalidArgument("Invalid png compression level");
+			}
+		}
+		if(vars.count("png-filter")) {
+			exportOptions.png.filter = tc::file_as_img::PngOptions::parseFilter(vars["png-filter"].as<std::string>());
+		}
+		if(vars.count("png-strategy")) {
+			exportOptions.png.strategy = tc::file_as_img::PngOptions::parseStrategy(vars["png-strategy"].as<std::string>());
+		}
+		if(vars.count("jpeg-quality"))
+		{
+			exportOptions.jpeg.quality = vars["jpeg-quality"].as<int>();
+			if(exportOptions.jpeg.quality < 1 || exportOptions.jpeg.quality > 100) {
+				throw tc::err::exc::InvalidArgument("Invalid jpeg quality");
+			}
+		}
+		if(vars.count("jpeg-subsampling")) {
+			exportOptions.jpeg.subsampling = tc::file_as_img::JpegOptions::parseSubsampling(vars["jpeg-subsampling"].as<std::string>());
+		}
+		exportOptions.jpeg.progressive = vars.count("jpeg-progressive") > 0;
+		exportOptions.webp.lossless = vars.count("webp-lossless") > 0;
+		if(vars.count("webp-quality"))
+		{
+			exportOptions.webp.quality = vars["webp-quality"].as<float>();
+			if(exportOptions.webp.quality < 0 || exportOptions.webp.quality > 100) {
+				throw tc::err::exc::InvalidArgument("Invalid webp quality");
+			}
+		}
+		if(vars.count("webp-method"))
+		{
+			exportOptions.webp.method = vars["webp-method"].as<int>();
+			if(exportOptions.webp.method < 0 || exportOptions.webp.method > 6) {
+				throw tc::err::exc::InvalidArgument("Invalid webp method");
+			}
+		}
+	}
+	catch(std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+	std::shared_ptr<tc::file_as_img::DocumentCache> documentCache;
+	if(std::size_t budget = vars["document-cache-mb"].as<std::size_t>()) {
+		documentCache = std::make_shared<tc::file_as_img::DocumentCache>(budget << 20);
+	}
+	converter.setDocumentCache(documentCache);
+	std::shared_ptr<tc::file_as_img::fs::RenderCache> renderCache;
+	if(vars.count("render-cache-dir"))
+	{
+		try
+		{
+			renderCache = std::make_shared<tc::file_as_img::fs::RenderCache>(
+				vars["render-cache-dir"].as<std::string>(), std::uintmax_t(vars["render-cache-mb"].as<std::size_t>()) << 20
+			);
+		}
+		catch(std::exception& e)
+		{
+			std::cerr << e.what() << std::endl;
+			return 1;
+		}
+	}
+	converter.setRenderCache(renderCache);
+	std::vector<std::shared_ptr<tc::file_as_img::IExportObserver>> observers;
+	std::shared_ptr<VSStats> stats;
+	if(vars.count("stats"))
+	{
+		stats = std::make_shared<VSStats>();
+		observers.push_back(stats);
+	}
+	std::shared_ptr<VSTraceRecorder> trace;
+	if(vars.count("trace"))
+	{
+		trace = std::make_shared<VSTraceRecorder>();
+		observers.push_back(trace);
+	}
+	if(observers.size() == 1) {
+		exportOptions.observer = observers.front();
+	}
+	else if(observers.size() > 1) {
+		exportOptions.observer = std::make_shared<tc::file_as_img::ObserverList>(std::move(observers));
+	}
+	auto writeReports = [&stats, &trace, &vars] {
+		if(stats)
+		{
+			std::string statsPath = vars["stats"].as<std::string>();
+			if(statsPath == "-") {
+				stats->writeJson(std::cerr);
+			}
+			else
+			{
+				std::ofstream statsFile(statsPath);
+				stats->writeJson(statsFile);
+				if(!statsFile) {
+					std::cerr << "Unable to write stats to " << statsPath << std::endl;
+				}
+			}
+		}
+		if(trace)
+		{
+			std::string tracePath = vars["trace"].as<std::string>();
+			std::ofstream traceFile(tracePath);
+			trace->writeJson(traceFile);
+			if(!traceFile) {
+				std::cerr << "Unable to write trace to " << tracePath << std::endl;
+			}
+		}
+	};
+
+	if(vars.count("serve"))
+	{
+		try
+		{
+			VSServer server(
+				converter, std::max<std::size_t>(1, vars["jobs"].as<std::size_t>()), vars["serve"].as<std::string>(),
+				exportOptions
+			);
+			server.setMaxConnections(vars["max-connections"].as<std::size_t>());
+			server.run();
+		}
+		catch(std::exception& e)
+		{
+			std::cerr << e.what() << std::endl;
+			return 2;
+		}
+	}
+
+	if(vars.count("manifest"))
+	{
+		std::string manifestPath = vars["manifest"].as<std::string>();
+		std::ifstream manifestFile;
+		if(manifestPath != "-")
+		{
+			manifestFile.open(manifestPath);
+			if(!manifestFile) {
+				std::cerr << "Unable to open manifest " << manifestPath << std::endl;
+				return 1;
 			}
-		);
+		}
+		VSBatch batch(converter, std::max<std::size_t>(1, vars["jobs"].as<std::size_t>()), exportOptions);
+		bool succeeded = batch.run(manifestPath == "-" ? std::cin : manifestFile, std::cout);
+		writeReports();
+		return succeeded ? 0 : 2;
+	}
+
+	VSConverter::Job job;
+	job.file = vars["input-file"].as<std::string>();
+	job.fileFormat = vars["input-format"].as<std::string>();
+	job.outputDir = vars["output-dir"].as<std::string>();
+	job.imageFormat = vars["output-format"].as<std::string>();
+	job.options = exportOptions;
+	try
+	{
+		if(vars.count("stream"))
+		{
+			VSFrameWriter writer(vars["stream"].as<int>());
+			converter.stream(job, writer);
+		}
+		else
+		{
+			converter.convert(job, [](const tc::file_as_img::fs::TypesHolder::String& name) {
+				std::cout << name << std::endl;
+			});
+		}
 	}
 	catch(std::exception& e)
 	{
 		std::cerr << e.what() << std::endl;
+		writeReports();
 		return 2;
 	}
+	writeReports();
 
 	return 0;
 }
\ No newline at end of file